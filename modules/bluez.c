@@ -167,6 +167,8 @@ static void bz_adapter_free ( gchar *object )
   trigger = !adapters;
   if(trigger)
     trigger_emit("bluez_running");
+  else
+    module_func_changed("bluezadapter");
   g_cancellable_cancel(adapter->cancel);
   if(adapter->timeout_handle)
     g_source_remove(adapter->timeout_handle);
@@ -798,21 +800,26 @@ static value_t bz_expr_device ( vm_t *vm, value_t p[], gint np )
   return value_na;
 }
 
+ModuleFunctionV1 sfwbar_module_functions[] = {
+  { "bluezscan", bz_action_scan, MODULE_FUNC_ACTION, NULL },
+  { "bluezpower", bz_action_power, MODULE_FUNC_ACTION, NULL },
+  { "bluezdiscoverable", bz_action_discoverable, MODULE_FUNC_ACTION, NULL },
+  { "bluezconnect", bz_action_connect, MODULE_FUNC_ACTION, NULL },
+  { "bluezpair", bz_action_pair, MODULE_FUNC_ACTION, NULL },
+  { "bluezdisconnect", bz_action_disconnect, MODULE_FUNC_ACTION, NULL },
+  { "bluezremove", bz_action_remove, MODULE_FUNC_ACTION, NULL },
+  { "bluezadapter", bz_expr_adapter, MODULE_FUNC_PUSH,
+    (gchar *[]){ "bluez_adapter", "bluez_running", NULL } },
+  { "bluezdevice", bz_expr_device, MODULE_FUNC_PUSH,
+    (gchar *[]){ "bluez_updated", "bluez_removed", NULL } },
+  { NULL }
+};
+
 gboolean sfwbar_module_init ( void )
 {
   if( !(bz_con = g_bus_get_sync(G_BUS_TYPE_SYSTEM, NULL, NULL)) )
     return FALSE;
 
-  vm_func_add("bluezscan", bz_action_scan, TRUE);
-  vm_func_add("bluezpower", bz_action_power, TRUE);
-  vm_func_add("bluezdiscoverable", bz_action_discoverable, TRUE);
-  vm_func_add("bluezconnect", bz_action_connect, TRUE);
-  vm_func_add("bluezpair", bz_action_pair, TRUE);
-  vm_func_add("bluezdisconnect", bz_action_disconnect, TRUE);
-  vm_func_add("bluezremove", bz_action_remove, TRUE);
-  vm_func_add("bluezadapter", bz_expr_adapter, FALSE);
-  vm_func_add("bluezdevice", bz_expr_device, FALSE);
-
   g_bus_watch_name(G_BUS_TYPE_SYSTEM, bz_serv, G_BUS_NAME_WATCHER_FLAGS_NONE,
       bz_name_appeared_cb, bz_name_disappeared_cb, NULL, NULL);
 
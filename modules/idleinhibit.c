@@ -62,10 +62,15 @@ static value_t idle_inhibitor_action ( vm_t *vm, value_t p[], gint np )
   return value_na;
 }
 
+ModuleFunctionV1 sfwbar_module_functions[] = {
+  { "idleinhibitstate", idle_inhibit_state, MODULE_FUNC_PUSH,
+    (gchar *[]){ "idleinhibitor", NULL } },
+  { "setidleinhibitor", idle_inhibitor_action, MODULE_FUNC_ACTION, NULL },
+  { NULL }
+};
+
 gboolean sfwbar_module_init ( void )
 {
-  vm_func_add("idleinhibitstate", idle_inhibit_state, FALSE);
-  vm_func_add("setidleinhibitor", idle_inhibitor_action, TRUE);
   idle_inhibit_manager = wayland_iface_register(
           zwp_idle_inhibit_manager_v1_interface.name, 1, 1,
           &zwp_idle_inhibit_manager_v1_interface);
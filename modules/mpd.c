@@ -245,11 +245,16 @@ static value_t mpd_set_passwd ( vm_t *vm, value_t p[], gint np )
   return value_na;
 }
 
+ModuleFunctionV1 sfwbar_module_functions[] = {
+  { "mpd", mpd_expr_func, MODULE_FUNC_PUSH,
+    (gchar *[]){ "mpd", "mpd-progress", NULL } },
+  { "mpdcommand", mpd_command, MODULE_FUNC_ACTION, NULL },
+  { "mpdsetpassword", mpd_set_passwd, MODULE_FUNC_ACTION, NULL },
+  { NULL }
+};
+
 gboolean sfwbar_module_init ( void )
 {
-  vm_func_add("mpd", mpd_expr_func, FALSE);
-  vm_func_add("mpdcommand", mpd_command, TRUE);
-  vm_func_add("mpdsetpassword", mpd_set_passwd, TRUE);
   if(mpd_connect(NULL))
     g_timeout_add (1000,(GSourceFunc )mpd_connect,NULL);
   return TRUE;
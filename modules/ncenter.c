@@ -11,6 +11,11 @@ typedef struct _dn_action {
   gchar *title;
 } dn_action;
 
+typedef struct _dn_group {
+  gchar *app_name;
+  GQueue notifs;
+} dn_group;
+
 typedef struct _dn_notification {
   gchar *app_name, *app_icon, *summary, *body;
   gint32 timeout;
@@ -22,10 +27,14 @@ typedef struct _dn_notification {
   gint32 x,y;
   gchar urgency;
   /* need image data */
-  guint timeout_handle;
+  dn_group *group;
+  GList *group_link, *wheel_link;
+  guint wheel_slot, wheel_rounds;
 } dn_notification;
 
 #define DN_NOTIFICATION(x) ((dn_notification *)(x))
+#define DN_WHEEL_SLOTS 64
+#define DN_WHEEL_TICK 250
 
 gint64 sfwbar_module_signature = 0x73f4d956a1;
 guint16 sfwbar_module_version = MODULE_API_VERSION;
@@ -34,7 +43,9 @@ static GDBusConnection *dn_con;
 static guint32 dn_id_counter = 1;
 static guint dn_pixbuf_counter;
 
-static GList *notif_list;
+static GHashTable *notif_hash, *group_hash;
+static GList *dn_wheel[DN_WHEEL_SLOTS];
+static guint dn_wheel_pos, dn_wheel_count, dn_wheel_handle;
 static gchar *expanded_group;
 static gint32 default_timeout = 0;
 
@@ -85,10 +96,57 @@ static const gchar dn_iface_xml[] =
   " </interface>"
   "</node>";
 
+static void dn_group_free ( dn_group *group )
+{
+  g_queue_clear(&group->notifs);
+  g_free(group->app_name);
+  g_free(group);
+}
+
+static void dn_group_add ( dn_notification *notif )
+{
+  dn_group *group;
+
+  if( !(group = g_hash_table_lookup(group_hash, notif->app_name)) )
+  {
+    group = g_malloc0(sizeof(dn_group));
+    group->app_name = g_strdup(notif->app_name);
+    g_hash_table_insert(group_hash, group->app_name, group);
+  }
+  g_queue_push_tail(&group->notifs, notif);
+  notif->group = group;
+  notif->group_link = group->notifs.tail;
+}
+
+static void dn_group_remove ( dn_notification *notif )
+{
+  dn_group *group;
+
+  if( !(group = notif->group) )
+    return;
+
+  g_queue_delete_link(&group->notifs, notif->group_link);
+  notif->group = NULL;
+  notif->group_link = NULL;
+  if(g_queue_is_empty(&group->notifs))
+    g_hash_table_remove(group_hash, group->app_name);
+}
+
+static void dn_wheel_remove ( dn_notification *notif )
+{
+  if(!notif->wheel_link)
+    return;
+
+  dn_wheel[notif->wheel_slot] =
+    g_list_delete_link(dn_wheel[notif->wheel_slot], notif->wheel_link);
+  notif->wheel_link = NULL;
+  dn_wheel_count--;
+}
+
 static void dn_notification_free ( dn_notification *notif )
 {
-  if(notif->timeout_handle)
-    g_source_remove(notif->timeout_handle);
+  dn_wheel_remove(notif);
+  dn_group_remove(notif);
   if(notif->time)
     g_date_time_unref(notif->time);
   g_free(notif->app_name);
@@ -108,20 +166,12 @@ static void dn_notification_free ( dn_notification *notif )
 
 static dn_notification *dn_notification_lookup ( guint32 id )
 {
-  GList *iter;
-
-  for(iter=notif_list; iter; iter=g_list_next(iter))
-    if(DN_NOTIFICATION(iter->data)->id == id)
-      break;
-  if(!iter)
-    return NULL;
-  return iter->data;
+  return g_hash_table_lookup(notif_hash, GUINT_TO_POINTER(id));
 }
 
 static void dn_notification_close ( guint32 id, guchar reason )
 {
   dn_notification *notif;
-  GList *iter;
 
   g_debug("ncenter: close event: %d", id);
 
@@ -132,18 +182,12 @@ static void dn_notification_close ( guint32 id, guchar reason )
       g_strdup_printf("%d", id));
   trigger_emit("notification-group");
 
-  notif_list = g_list_remove(notif_list, notif);
+  g_hash_table_remove(notif_hash, GUINT_TO_POINTER(id));
+  dn_notification_free(notif);
 
-  if(!g_strcmp0(notif->app_name, expanded_group))
-  {
-    for(iter=notif_list; iter; iter=g_list_next(iter))
-      if(!g_strcmp0(DN_NOTIFICATION(iter->data)->app_name, notif->app_name))
-        break;
-    if(!iter)
-      g_free(g_steal_pointer(&expanded_group));
-  }
+  if(expanded_group && !g_hash_table_contains(group_hash, expanded_group))
+    g_free(g_steal_pointer(&expanded_group));
 
-  dn_notification_free(notif);
   g_dbus_connection_emit_signal(dn_con, NULL, dn_path, dn_bus,
       "NotificationClosed", g_variant_new("(uu)", id, reason), NULL);
 }
@@ -218,20 +262,54 @@ static void dn_notification_action ( guint32 id, gchar *action )
   g_free(token);
 }
 
-gboolean dn_timeout ( dn_notification *notif )
+/* expire notifications on a single timer wheel instead of a source each */
+static gboolean dn_wheel_tick ( gpointer d )
 {
-  notif->timeout_handle = 0;
-  dn_notification_close(notif->id, 1);
+  GList *iter, *expired = NULL;
+  dn_notification *notif;
+
+  dn_wheel_pos = (dn_wheel_pos + 1) % DN_WHEEL_SLOTS;
+  for(iter=dn_wheel[dn_wheel_pos]; iter; iter=g_list_next(iter))
+  {
+    notif = iter->data;
+    if(notif->wheel_rounds)
+      notif->wheel_rounds--;
+    else
+      expired = g_list_prepend(expired, GUINT_TO_POINTER(notif->id));
+  }
+
+  for(iter=expired; iter; iter=g_list_next(iter))
+    dn_notification_close(GPOINTER_TO_UINT(iter->data), 1);
+  g_list_free(expired);
+
+  if(dn_wheel_count)
+    return TRUE;
+  dn_wheel_handle = 0;
   return FALSE;
 }
 
+static void dn_wheel_insert ( dn_notification *notif )
+{
+  guint ticks;
+
+  ticks = notif->timeout / DN_WHEEL_TICK + 1;
+  notif->wheel_slot = (dn_wheel_pos + ticks) % DN_WHEEL_SLOTS;
+  notif->wheel_rounds = (ticks - 1) / DN_WHEEL_SLOTS;
+  dn_wheel[notif->wheel_slot] =
+    g_list_prepend(dn_wheel[notif->wheel_slot], notif);
+  notif->wheel_link = dn_wheel[notif->wheel_slot];
+  dn_wheel_count++;
+
+  if(!dn_wheel_handle)
+    dn_wheel_handle = g_timeout_add(DN_WHEEL_TICK, dn_wheel_tick, NULL);
+}
+
 guint32 dn_notification_parse ( GVariant *params )
 {
   dn_notification *notif;
   GVariantIter *aiter;
   GVariant *hints;
   GArray *action_ids, *action_titles;
-  GList *iter;
   vm_store_t *store;
   value_t v1;
   gchar *action_title, *action_id;
@@ -239,16 +317,16 @@ guint32 dn_notification_parse ( GVariant *params )
 
   g_variant_get(params, "(susssas@a{sv}i)", NULL, &id,
       NULL,NULL,NULL,NULL,NULL,NULL);
-  for(iter=notif_list; iter; iter=g_list_next(iter))
-    if(DN_NOTIFICATION(iter->data)->id == id)
-      break;
 
-  if(iter)
-    notif = iter->data;
+  if( !(notif = dn_notification_lookup(id)) )
+    notif = g_malloc0(sizeof(dn_notification));
   else
   {
-    notif = g_malloc0(sizeof(dn_notification));
-    notif_list = g_list_append(notif_list, notif);
+    dn_wheel_remove(notif);
+    g_free(notif->app_name);
+    g_free(notif->app_icon);
+    g_free(notif->summary);
+    g_free(notif->body);
   }
   g_variant_get(params, "(susssas@a{sv}i)", &notif->app_name, &notif->id,
       &notif->app_icon, &notif->summary,
@@ -256,6 +334,12 @@ guint32 dn_notification_parse ( GVariant *params )
 
   if(notif->id < 1)
     notif->id = dn_id_counter++;
+  g_hash_table_insert(notif_hash, GUINT_TO_POINTER(notif->id), notif);
+
+  if(notif->group && g_strcmp0(notif->group->app_name, notif->app_name))
+    dn_group_remove(notif);
+  if(!notif->group)
+    dn_group_add(notif);
 
   g_clear_pointer(&notif->category, g_free);
   g_variant_lookup(hints, "category", "s", &notif->category);
@@ -290,8 +374,7 @@ guint32 dn_notification_parse ( GVariant *params )
   if(notif->timeout == -1)
     notif->timeout = notif->resident?0:default_timeout;
   if(notif->timeout > 0)
-    notif->timeout_handle =
-      g_timeout_add(notif->timeout, (GSourceFunc)dn_timeout, notif);
+    dn_wheel_insert(notif);
 
   action_ids = g_array_new(FALSE, FALSE, sizeof(value_t));
   action_titles = g_array_new(FALSE, FALSE, sizeof(value_t));
@@ -433,22 +516,15 @@ static value_t dn_get_func ( vm_t *vm, value_t p[], gint np )
 static value_t dn_group_func ( vm_t *vm, value_t p[], gint np )
 {
   dn_notification *notif;
-  GList *iter;
-  guint32 id, count = 0;
-  gboolean header = FALSE;
+  guint32 id, count;
 
   if(np!=1 || !value_is_string(p[0]))
     return value_na;
 
   if( !(id = g_ascii_strtoull(p[0].value.string, NULL, 10)) )
     return value_na;
-  for(iter=notif_list; iter; iter=g_list_next(iter))
-    if(DN_NOTIFICATION(iter->data)->id == id)
-      break;
-
-  if(!iter)
+  if( !(notif = dn_notification_lookup(id)) || !notif->group )
     return value_na;
-  notif = iter->data;
 
   if(expanded_group)
   {
@@ -458,18 +534,11 @@ static value_t dn_group_func ( vm_t *vm, value_t p[], gint np )
       return value_na;
   }
 
-  for(iter=notif_list; iter; iter=g_list_next(iter))
-    if(!g_strcmp0(DN_NOTIFICATION(iter->data)->app_name, notif->app_name))
-    {
-      if(!count && iter->data==notif)
-        header = TRUE;
-      count++;
-    }
-
+  count = g_queue_get_length(&notif->group->notifs);
   if(count==1)
     return value_new_string(g_strdup("sole"));
 
-  if(count>1 && header)
+  if(count>1 && g_queue_peek_head(&notif->group->notifs)==notif)
     return value_new_string(g_strdup("header"));
 
   return value_na;
@@ -482,18 +551,15 @@ static value_t dn_active_group_func ( vm_t *vm, value_t p[], gint np )
 
 static value_t dn_count_func ( vm_t *vm, value_t p[], gint np )
 {
-  GList *iter;
   dn_notification *notif;
   gdouble result = 0;
   guint32 id;
 
   if(np!=1 || !value_is_string(p[0]))
-    return value_new_numeric(g_list_length(notif_list));
+    return value_new_numeric(g_hash_table_size(notif_hash));
   if( (id=g_ascii_strtoull(p[0].value.string, NULL, 10)) )
-    if( (notif=dn_notification_lookup(id)) )
-      for(iter=notif_list; iter; iter=g_list_next(iter))
-        if(!g_strcmp0(DN_NOTIFICATION(iter->data)->app_name, notif->app_name))
-          result++;
+    if( (notif=dn_notification_lookup(id)) && notif->group )
+      result = g_queue_get_length(&notif->group->notifs);
 
   return value_new_numeric(result);
 }
@@ -557,6 +623,10 @@ static value_t dn_action_action ( vm_t *vm, value_t p[], gint np )
 
 gboolean sfwbar_module_init ( void )
 {
+  notif_hash = g_hash_table_new(g_direct_hash, g_direct_equal);
+  group_hash = g_hash_table_new_full(g_str_hash, g_str_equal, NULL,
+      (GDestroyNotify)dn_group_free);
+
   vm_func_add("notificationget", dn_get_func, FALSE);
   vm_func_add("notificationgroup", dn_group_func, FALSE);
   vm_func_add("notificationactivegroup", dn_active_group_func, FALSE);
@@ -17,20 +17,27 @@
 #define SOCKADDR_IN(x) ((struct sockaddr_in *)x)
 #define SOCKADDR_IN6(x) ((struct sockaddr_in6 *)x)
 #define IFACE_INFO(x) ((iface_info *)x)
+#define NET_STATS_SAMPLES 33
+
+typedef struct _net_sample {
+  gint64 time;
+  guint64 rx_bytes, tx_bytes;
+} net_sample_t;
 
 typedef struct _iface_info {
   gchar *name;
   GMutex mutex;
-  gboolean invalid;
   struct in_addr ip, mask, bcast, gateway;
   struct in6_addr ip6, mask6, bcast6, gateway6;
-  guint32 rx_packets, tx_packets, rx_bytes, tx_bytes;
-  guint32 prx_packets, ptx_packets, prx_bytes, ptx_bytes;
-  gint64 last_time, time_diff;
+  net_sample_t samples[NET_STATS_SAMPLES];
+  guint head, count;
   gchar *essid;
 } iface_info;
 
 iface_info *route;
+static GMutex stats_mutex;
+static gboolean stats_invalid;
+static guint smoothing = 1;
 
 gint64 sfwbar_module_signature = 0x73f4d956a1;
 guint16 sfwbar_module_version = MODULE_API_VERSION;
@@ -39,6 +46,7 @@ GList *iface_list;
 gint qual, level, noise;
 
 static void net_update_essid ( gchar * );
+static void net_update_traffic ( void );
 
 static iface_info *net_iface_get ( gchar *name, gboolean create )
 {
@@ -67,6 +75,19 @@ static void iface_free ( iface_info *iface )
   g_free(iface);
 }
 
+static void net_stats_push ( iface_info *iface, gint64 ctime,
+    guint64 rx_bytes, guint64 tx_bytes )
+{
+  g_mutex_lock(&iface->mutex);
+  iface->head = (iface->head + 1) % NET_STATS_SAMPLES;
+  iface->samples[iface->head].time = ctime;
+  iface->samples[iface->head].rx_bytes = rx_bytes;
+  iface->samples[iface->head].tx_bytes = tx_bytes;
+  if(iface->count < NET_STATS_SAMPLES)
+    iface->count++;
+  g_mutex_unlock(&iface->mutex);
+}
+
 static void net_update_ifaddrs ( void )
 {
   struct ifaddrs *addrs, *iter;
@@ -135,41 +156,77 @@ static void net_iface_update ( gint32 iidx, struct in_addr gate,
 #include <linux/rtnetlink.h>
 #include <linux/wireless.h>
 
-static void net_update_traffic ( gchar *interface )
+static gint stats_sock = -1;
+static guint32 stats_seq = 1;
+
+/* fetch counters for all links with a single RTM_GETLINK dump */
+static void net_update_traffic ( void )
 {
-  gint64 ctime;
-  struct ifaddrs *addrs, *iter;
-  struct rtnl_link_stats *stats;
+  struct {
+    struct nlmsghdr hdr;
+    struct ifinfomsg ifm;
+  } nlreq;
+  struct nlmsghdr *hdr;
+  struct rtattr *rta;
+  struct rtnl_link_stats64 stats;
+  struct timeval tv;
   iface_info *iface;
+  gboolean done = FALSE, have_stats;
+  gchar buf[16384], *name;
+  gint64 ctime;
+  gssize len;
+  gint rtl;
 
-  iface = net_iface_get(interface, FALSE);
-  if(!iface || !iface->invalid)
+  if(stats_sock < 0)
+  {
+    if( (stats_sock = socket(AF_NETLINK, SOCK_RAW, NETLINK_ROUTE)) < 0 )
+      return;
+    tv.tv_sec = 0;
+    tv.tv_usec = 100000;
+    setsockopt(stats_sock, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+  }
+
+  memset(&nlreq, 0, sizeof(nlreq));
+  nlreq.hdr.nlmsg_type = RTM_GETLINK;
+  nlreq.hdr.nlmsg_flags = NLM_F_REQUEST | NLM_F_DUMP;
+  nlreq.hdr.nlmsg_len = sizeof(nlreq);
+  nlreq.hdr.nlmsg_seq = ++stats_seq;
+  nlreq.ifm.ifi_family = AF_UNSPEC;
+  if(send(stats_sock, &nlreq, sizeof(nlreq), 0) < 0)
     return;
 
-  getifaddrs(&addrs);
-  for(iter=addrs; iter; iter=iter->ifa_next)
-  {
-    if(!g_strcmp0(interface, iter->ifa_name) &&
-        iter->ifa_addr->sa_family == AF_PACKET)
+  ctime = g_get_monotonic_time();
+  while(!done && (len = recv(stats_sock, buf, sizeof(buf), 0)) > 0)
+    for(hdr = (struct nlmsghdr *)buf; NLMSG_OK(hdr, len);
+        hdr = NLMSG_NEXT(hdr, len))
     {
-      iface->prx_packets = iface->rx_packets;
-      iface->ptx_packets = iface->tx_packets;
-      iface->prx_bytes = iface->rx_bytes;
-      iface->ptx_bytes = iface->tx_bytes;
-
-      stats = ((struct rtnl_link_stats *)(iter->ifa_data));
-      iface->rx_packets = stats->rx_packets;
-      iface->tx_packets = stats->tx_packets;
-      iface->rx_bytes = stats->rx_bytes;
-      iface->tx_bytes = stats->tx_bytes;
-
-      ctime = g_get_monotonic_time();
-      iface->time_diff = ctime - iface->last_time;
-      iface->last_time = ctime;
-      iface->invalid = FALSE;
+      if(hdr->nlmsg_seq != stats_seq)
+        continue;
+      if(hdr->nlmsg_type == NLMSG_DONE || hdr->nlmsg_type == NLMSG_ERROR)
+      {
+        done = TRUE;
+        break;
+      }
+      if(hdr->nlmsg_type != RTM_NEWLINK)
+        continue;
+
+      name = NULL;
+      have_stats = FALSE;
+      rta = IFLA_RTA(NLMSG_DATA(hdr));
+      rtl = IFLA_PAYLOAD(hdr);
+      for(; RTA_OK(rta, rtl); rta=RTA_NEXT(rta, rtl))
+        if(rta->rta_type == IFLA_IFNAME)
+          name = RTA_DATA(rta);
+        else if(rta->rta_type == IFLA_STATS64 &&
+            RTA_PAYLOAD(rta) >= sizeof(stats))
+        {
+          memcpy(&stats, RTA_DATA(rta), sizeof(stats));
+          have_stats = TRUE;
+        }
+
+      if(name && have_stats && (iface = net_iface_get(name, FALSE)) )
+        net_stats_push(iface, ctime, stats.rx_bytes, stats.tx_bytes);
     }
-  }
-  freeifaddrs(addrs);
 }
 
 static void net_update_essid ( gchar *interface )
@@ -365,38 +422,21 @@ static gboolean net_rt_parse (GIOChannel *chan, GIOCondition cond, gpointer d)
 #include <net/if_dl.h>
 #include <net/route.h>
 
-static void net_update_traffic ( gchar *interface )
+static void net_update_traffic ( void )
 {
-  gint64 ctime;
   struct ifaddrs *addrs, *iter;
   iface_info *iface;
+  gint64 ctime;
 
-  iface = net_iface_get(interface, FALSE);
-  if(!iface || !iface->invalid)
+  if(getifaddrs(&addrs))
     return;
-
-  getifaddrs(&addrs);
+  ctime = g_get_monotonic_time();
   for(iter=addrs; iter; iter=iter->ifa_next)
-  {
-    if(!g_strcmp0(interface, iter->ifa_name) && iter->ifa_addr &&
-        iter->ifa_addr->sa_family==AF_LINK)
-    {
-      iface->prx_packets = iface->rx_packets;
-      iface->ptx_packets = iface->tx_packets;
-      iface->prx_bytes = iface->rx_bytes;
-      iface->ptx_bytes = iface->tx_bytes;
-
-      iface->rx_packets = ((struct if_data *)(iter->ifa_data))->ifi_ipackets;
-      iface->tx_packets = ((struct if_data *)(iter->ifa_data))->ifi_opackets;
-      iface->rx_bytes = ((struct if_data *)(iter->ifa_data))->ifi_ibytes;
-      iface->tx_bytes = ((struct if_data *)(iter->ifa_data))->ifi_obytes;
-
-      ctime = g_get_monotonic_time();
-      iface->time_diff = ctime - iface->last_time;
-      iface->last_time = ctime;
-      iface->invalid = FALSE;
-    }
-  }
+    if(iter->ifa_addr && iter->ifa_addr->sa_family==AF_LINK &&
+        iter->ifa_data && (iface = net_iface_get(iter->ifa_name, FALSE)) )
+      net_stats_push(iface, ctime,
+          ((struct if_data *)(iter->ifa_data))->ifi_ibytes,
+          ((struct if_data *)(iter->ifa_data))->ifi_obytes);
   freeifaddrs(addrs);
 }
 
@@ -645,6 +685,38 @@ static gboolean net_rt_request ( gint sock )
 
 #endif /* Linux || FreeBSD || OpenBSD */
 
+static void net_stats_refresh ( void )
+{
+  g_mutex_lock(&stats_mutex);
+  if(stats_invalid)
+  {
+    stats_invalid = FALSE;
+    net_update_traffic();
+  }
+  g_mutex_unlock(&stats_mutex);
+}
+
+static gdouble net_stats_rate ( iface_info *iface, gboolean tx )
+{
+  net_sample_t *first, *last;
+  guint64 v1, v2;
+  guint n;
+
+  if(iface->count < 2)
+    return 0.0;
+
+  n = MIN(smoothing, iface->count - 1);
+  last = &iface->samples[iface->head];
+  first = &iface->samples[(iface->head + NET_STATS_SAMPLES - n) %
+    NET_STATS_SAMPLES];
+  v1 = tx? first->tx_bytes : first->rx_bytes;
+  v2 = tx? last->tx_bytes : last->rx_bytes;
+
+  if(last->time <= first->time || v2 < v1)
+    return 0.0;
+  return (gdouble)(v2 - v1) * 1000000 / (last->time - first->time);
+}
+
 static value_t network_func_netstat ( vm_t *vm, value_t p[], gint np )
 {
   iface_info *iface;
@@ -660,26 +732,32 @@ static value_t network_func_netstat ( vm_t *vm, value_t p[], gint np )
   if(!iface)
     return value_na;
 
+  if(!g_ascii_strcasecmp(p[0].value.string, "rxrate") ||
+      !g_ascii_strcasecmp(p[0].value.string, "txrate"))
+    net_stats_refresh();
+
   g_mutex_lock(&iface->mutex);
   if(!g_ascii_strcasecmp(p[0].value.string, "signal"))
     result = net_get_signal(route?route->name:NULL);
   else if(!g_ascii_strcasecmp(p[0].value.string, "rxrate"))
-  {
-    net_update_traffic(iface->name);
-    result = (gdouble)(iface->rx_bytes-iface->prx_bytes)*
-        1000000/iface->time_diff;
-  }
+    result = net_stats_rate(iface, FALSE);
   else if(!g_ascii_strcasecmp(p[0].value.string, "txrate"))
-  {
-    net_update_traffic(iface->name);
-    result = (gdouble)(iface->tx_bytes-iface->ptx_bytes)*
-      1000000/iface->time_diff;
-  }
+    result = net_stats_rate(iface, TRUE);
   g_mutex_unlock(&iface->mutex);
 
   return value_new_numeric(result);
 }
 
+static value_t network_action_smoothing ( vm_t *vm, value_t p[], gint np )
+{
+  vm_param_check_np(vm, np, 1, "NetSetSmoothing");
+  vm_param_check_numeric(vm, p, 0, "NetSetSmoothing");
+
+  smoothing = CLAMP((gint)value_as_numeric(p[0]), 1, NET_STATS_SAMPLES-1);
+
+  return value_na;
+}
+
 static gchar *net_get_cidr ( guint32 addr )
 {
   gint i;
@@ -752,6 +830,7 @@ gboolean sfwbar_module_init ( void )
   {
     vm_func_add("netstat", network_func_netstat, FALSE);
     vm_func_add("netinfo", network_func_netinfo, FALSE);
+    vm_func_add("netsetsmoothing", network_action_smoothing, TRUE);
     g_io_add_watch(chan,G_IO_IN | G_IO_PRI |G_IO_ERR | G_IO_HUP,
         net_rt_parse, NULL);
     net_rt_request(sock);
@@ -765,8 +844,5 @@ gboolean sfwbar_module_init ( void )
 
 void sfwbar_module_invalidate ( void )
 {
-  GList *iter;
-
-  for(iter=iface_list; iter; iter=g_list_next(iter))
-    IFACE_INFO(iter->data)->invalid = TRUE;
+  stats_invalid = TRUE;
 }
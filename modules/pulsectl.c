@@ -11,6 +11,8 @@
 #include "util/string.h"
 #include "vm/vm.h"
 
+#define PULSE_COALESCE_INTERVAL 16
+
 static gboolean pulse_connect_try ( void *data );
 gboolean invalid;
 
@@ -23,13 +25,26 @@ typedef struct _pulse_info {
   pa_channel_map cmap;
 } pulse_info;
 
+typedef struct _pulse_table {
+  GHashTable *by_idx;
+  GHashTable *by_name;
+} pulse_table_t;
+
+/* an immutable copy of the device state, read by the expression functions */
+typedef struct _pulse_snapshot {
+  gint refcount;
+  pulse_table_t tables[3];
+  gchar *default_device[3];
+  gchar *default_control[3];
+} pulse_snapshot_t;
+
 typedef struct _pulse_interface {
   const gchar *prefix;
   gchar *default_name;
   gchar *default_device;
   gchar *default_control;
   gboolean fixed;
-  GList *list;
+  pulse_table_t devices;
   pa_operation *(*set_volume)(pa_context *, uint32_t, const pa_cvolume *,
       pa_context_success_cb_t, void *);
   pa_operation *(*set_mute)(pa_context *, uint32_t, int,
@@ -46,32 +61,181 @@ extern ModuleInterfaceV1 sfwbar_interface;
 
 static pa_context *pctx;
 static pulse_interface_t pulse_interfaces[];
+static pulse_snapshot_t *snapshot;
+static GMutex snapshot_mutex;
+static guint pulse_flush_id;
+
+static void pulse_info_free ( pulse_info *info )
+{
+  g_free(info->name);
+  g_free(info->icon);
+  g_free(info->form);
+  g_free(info->port);
+  g_free(info->monitor);
+  g_free(info->description);
+  g_free(info);
+}
+
+static pulse_info *pulse_info_dup ( pulse_info *info )
+{
+  pulse_info *copy;
+
+  copy = g_memdup2(info, sizeof(pulse_info));
+  copy->name = g_strdup(info->name);
+  copy->icon = g_strdup(info->icon);
+  copy->form = g_strdup(info->form);
+  copy->port = g_strdup(info->port);
+  copy->monitor = g_strdup(info->monitor);
+  copy->description = g_strdup(info->description);
+
+  return copy;
+}
+
+static void pulse_table_init ( pulse_table_t *table )
+{
+  table->by_idx = g_hash_table_new_full(g_direct_hash, g_direct_equal, NULL,
+      (GDestroyNotify)pulse_info_free);
+  table->by_name = g_hash_table_new(g_str_hash, g_str_equal);
+}
+
+static void pulse_table_clear ( pulse_table_t *table )
+{
+  g_clear_pointer(&table->by_name, g_hash_table_destroy);
+  g_clear_pointer(&table->by_idx, g_hash_table_destroy);
+}
+
+static void pulse_table_unname ( pulse_table_t *table, pulse_info *info )
+{
+  GHashTableIter hiter;
+  pulse_info *other;
+
+  if(!info->name || g_hash_table_lookup(table->by_name, info->name) != info)
+    return;
+
+  g_hash_table_remove(table->by_name, info->name);
+
+  /* several streams may share a name, fall back onto another one */
+  g_hash_table_iter_init(&hiter, table->by_idx);
+  while(g_hash_table_iter_next(&hiter, NULL, (gpointer *)&other))
+    if(other != info && !g_strcmp0(other->name, info->name))
+    {
+      g_hash_table_insert(table->by_name, other->name, other);
+      break;
+    }
+}
+
+static void pulse_table_set_name ( pulse_table_t *table, pulse_info *info,
+    const gchar *name )
+{
+  if(info->name && !g_strcmp0(info->name, name))
+    return;
+
+  pulse_table_unname(table, info);
+  g_free(info->name);
+  info->name = g_strdup(name);
+  if(info->name)
+    g_hash_table_insert(table->by_name, info->name, info);
+}
 
 static pulse_info *pulse_info_from_idx ( pulse_interface_t *iface, guint32 idx,
     gboolean new )
 {
-  GList *iter;
   pulse_info *info;
 
-  for(iter=iface->list; iter; iter=g_list_next(iter))
-    if(((pulse_info *)iter->data)->idx == idx)
-      return iter->data;
+  if( (info = g_hash_table_lookup(iface->devices.by_idx,
+          GUINT_TO_POINTER(idx))) || !new )
+    return info;
 
-  if(new)
+  info = g_malloc0(sizeof(pulse_info));
+  info->idx = idx;
+  g_hash_table_insert(iface->devices.by_idx, GUINT_TO_POINTER(idx), info);
+
+  return info;
+}
+
+static void pulse_snapshot_unref ( pulse_snapshot_t *snap )
+{
+  gint i;
+
+  if(!snap || !g_atomic_int_dec_and_test(&snap->refcount))
+    return;
+
+  for(i=0; i<3; i++)
   {
-    info = g_malloc0(sizeof(pulse_info));
-    iface->list = g_list_prepend(iface->list, info);
-    return info;
+    pulse_table_clear(&snap->tables[i]);
+    g_free(snap->default_device[i]);
+    g_free(snap->default_control[i]);
   }
-  else
-    return NULL;
+  g_free(snap);
+}
+
+static pulse_snapshot_t *pulse_snapshot_get ( void )
+{
+  pulse_snapshot_t *snap;
+
+  g_mutex_lock(&snapshot_mutex);
+  if( (snap = snapshot) )
+    g_atomic_int_inc(&snap->refcount);
+  g_mutex_unlock(&snapshot_mutex);
+
+  return snap;
+}
+
+static void pulse_snapshot_build ( void )
+{
+  pulse_snapshot_t *snap, *old;
+  GHashTableIter hiter;
+  pulse_info *info, *copy;
+  gint i;
+
+  snap = g_malloc0(sizeof(pulse_snapshot_t));
+  snap->refcount = 1;
+  for(i=0; i<3; i++)
+  {
+    pulse_table_init(&snap->tables[i]);
+    snap->default_device[i] = g_strdup(pulse_interfaces[i].default_device);
+    snap->default_control[i] = g_strdup(pulse_interfaces[i].default_control);
+
+    g_hash_table_iter_init(&hiter, pulse_interfaces[i].devices.by_idx);
+    while(g_hash_table_iter_next(&hiter, NULL, (gpointer *)&info))
+    {
+      copy = pulse_info_dup(info);
+      g_hash_table_insert(snap->tables[i].by_idx, GUINT_TO_POINTER(copy->idx),
+          copy);
+      if(copy->name && g_hash_table_lookup(pulse_interfaces[i].devices.by_name,
+            copy->name) == info)
+        g_hash_table_insert(snap->tables[i].by_name, copy->name, copy);
+    }
+  }
+
+  g_mutex_lock(&snapshot_mutex);
+  old = snapshot;
+  snapshot = snap;
+  g_mutex_unlock(&snapshot_mutex);
+  pulse_snapshot_unref(old);
+}
+
+static gboolean pulse_flush ( gpointer data )
+{
+  pulse_flush_id = 0;
+  pulse_snapshot_build();
+  trigger_emit("volume");
+
+  return G_SOURCE_REMOVE;
+}
+
+/* coalesce all changes within a frame into a single snapshot and trigger */
+static void pulse_changed ( void )
+{
+  if(!pulse_flush_id)
+    pulse_flush_id = g_timeout_add(PULSE_COALESCE_INTERVAL, pulse_flush,
+        NULL);
 }
 
 static pulse_interface_t pulse_interfaces[] = {
   {
     .prefix = "sink",
     .default_name = "default",
-    .list = NULL,
     .set_volume = pa_context_set_sink_volume_by_index,
     .set_mute = pa_context_set_sink_mute_by_index,
     .set_default = pa_context_set_default_sink,
@@ -79,7 +243,6 @@ static pulse_interface_t pulse_interfaces[] = {
   {
     .prefix = "source",
     .default_name = "default",
-    .list = NULL,
     .set_volume = pa_context_set_source_volume_by_index,
     .set_mute = pa_context_set_source_mute_by_index,
     .set_default = pa_context_set_default_source,
@@ -87,7 +250,6 @@ static pulse_interface_t pulse_interfaces[] = {
   {
     .prefix = "client",
     .default_name = "default",
-    .list = NULL,
     .set_volume = pa_context_set_sink_input_volume,
     .set_mute = pa_context_set_sink_input_mute,
   }
@@ -109,11 +271,10 @@ pulse_interface_t *pulse_interface_get ( gchar *name, gchar **ptr )
 }
 
 static pulse_info *pulse_addr_parse ( const gchar *addr,
-    pulse_interface_t *iface, gint *cidx )
+    pulse_table_t *table, const gchar *def, gint *cidx )
 {
   pa_channel_position_t cpos;
   pulse_info *info;
-  GList *iter;
   gchar *device, *channel;
   gint i;
   gchar *ptr;
@@ -136,18 +297,15 @@ static pulse_info *pulse_addr_parse ( const gchar *addr,
   if(device && g_str_has_prefix(device, "@pulse-"))
   {
     if( device && (ptr = strrchr(device, '-')) )
-      info = pulse_info_from_idx(iface, atoi(ptr+1), FALSE);
+      info = g_hash_table_lookup(table->by_idx,
+          GUINT_TO_POINTER(atoi(ptr+1)));
     else
       info = NULL;
   }
+  else if(device || def)
+    info = g_hash_table_lookup(table->by_name, device? device : def);
   else
-  {
-    for(iter=iface->list; iter; iter=g_list_next(iter))
-      if(!g_strcmp0(((pulse_info *)iter->data)->name,
-            device?device:iface->default_control))
-        break;
-    info = iter?iter->data:NULL;
-  }
+    info = NULL;
 
   if(cidx && info && channel)
   {
@@ -174,14 +332,15 @@ static void pulse_set_default_control ( pulse_interface_t *iface, const gchar *n
 
   if(g_str_has_prefix(name, "@pulse"))
   {
-    if( (info=pulse_addr_parse(name, iface, NULL)) )
+    if( (info=pulse_addr_parse(name, &iface->devices,
+          iface->default_control, NULL)) )
       name = info->name;
   }
 
   iface->fixed = fixed;
   g_free(iface->default_control);
   iface->default_control = g_strdup(name);
-  trigger_emit("volume");
+  pulse_changed();
 }
 
 static void pulse_set_default_device ( pulse_interface_t *iface,
@@ -205,7 +364,8 @@ static void pulse_set_default ( pulse_interface_t *iface, const gchar *name )
 
   if(g_str_has_prefix(name, "@pulse"))
   {
-    if( (info=pulse_addr_parse(name, iface, NULL)) )
+    if( (info=pulse_addr_parse(name, &iface->devices,
+          iface->default_control, NULL)) )
       name = info->name;
   }
 
@@ -215,29 +375,17 @@ static void pulse_set_default ( pulse_interface_t *iface, const gchar *name )
 
 static void pulse_remove_device ( pulse_interface_t *iface, guint32 idx )
 {
-  GList *iter;
   pulse_info *info;
 
-  for(iter=iface->list; iter; iter=g_list_next(iter))
-    if(((pulse_info *)iter->data)->idx == idx)
-      break;
+  if( !(info = pulse_info_from_idx(iface, idx, FALSE)) )
+    return;
 
-  if(iter)
-  {
-    info = iter->data;
-    iface->list = g_list_delete_link(iface->list, iter);
-
-    if(info->name)
-      trigger_emit_with_string("volume-conf-removed", "device_id",
-          g_strdup_printf("@pulse-%s-%d", iface->prefix, idx));
-    g_free(info->name);
-    g_free(info->icon);
-    g_free(info->form);
-    g_free(info->port);
-    g_free(info->monitor);
-    g_free(info->description);
-    g_free(info);
-  }
+  if(info->name)
+    trigger_emit_with_string("volume-conf-removed", "device_id",
+        g_strdup_printf("@pulse-%s-%d", iface->prefix, idx));
+  pulse_table_unname(&iface->devices, info);
+  g_hash_table_remove(iface->devices.by_idx, GUINT_TO_POINTER(idx));
+  pulse_changed();
 }
 
 static void pulse_operation ( pa_operation *o, gchar *cmd )
@@ -294,8 +442,7 @@ static void pulse_sink_cb ( pa_context *ctx, const pa_sink_info *pinfo,
 
   info = pulse_info_from_idx(&pulse_interfaces[0], pinfo->index, TRUE);
 
-  g_free(info->name);
-  info->name = g_strdup(pinfo->name);
+  pulse_table_set_name(&pulse_interfaces[0].devices, info, pinfo->name);
   g_free(info->icon);
   info->icon = g_strdup(pa_proplist_gets(pinfo->proplist,
         PA_PROP_DEVICE_ICON_NAME));
@@ -316,22 +463,22 @@ static void pulse_sink_cb ( pa_context *ctx, const pa_sink_info *pinfo,
   if(new)
     pulse_device_advertise(0, &pinfo->channel_map, pinfo->index);
 
-  trigger_emit("volume");
+  pulse_changed();
 }
 
 static void pulse_client_cb ( pa_context *ctx, const pa_client_info *cinfo,
     int eol, void *data )
 {
+  GHashTableIter hiter;
   pulse_info *info;
   gboolean change = FALSE;
-  GList *iter;
 
   if(!cinfo)
     return;
 
-  for(iter=pulse_interfaces[2].list; iter; iter=g_list_next(iter))
+  g_hash_table_iter_init(&hiter, pulse_interfaces[2].devices.by_idx);
+  while(g_hash_table_iter_next(&hiter, NULL, (gpointer *)&info))
   {
-    info = iter->data;
     if(info->client==cinfo->index && g_strcmp0(info->description, cinfo->name))
     {
       g_free(info->description);
@@ -341,7 +488,7 @@ static void pulse_client_cb ( pa_context *ctx, const pa_client_info *cinfo,
   }
 
   if(change)
-    trigger_emit("volume");
+    pulse_changed();
 }
 
 static void pulse_sink_input_cb ( pa_context *ctx,
@@ -355,8 +502,7 @@ static void pulse_sink_input_cb ( pa_context *ctx,
 
   new = !pulse_info_from_idx(&pulse_interfaces[2], pinfo->index, FALSE);
   info = pulse_info_from_idx(&pulse_interfaces[2], pinfo->index, TRUE);
-  g_free(info->name);
-  info->name = g_strdup(pinfo->name);
+  pulse_table_set_name(&pulse_interfaces[2].devices, info, pinfo->name);
   g_free(info->icon);
   info->icon = g_strdup(pa_proplist_gets(pinfo->proplist,
         PA_PROP_DEVICE_ICON_NAME));
@@ -368,7 +514,7 @@ static void pulse_sink_input_cb ( pa_context *ctx,
   info->mute = pinfo->mute;
   info->cmap = pinfo->channel_map;
   info->client = pinfo->client;
-  trigger_emit("volume");
+  pulse_changed();
 
   if(new)
     pulse_device_advertise(2, &pinfo->channel_map, pinfo->index);
@@ -386,8 +532,7 @@ static void pulse_source_cb ( pa_context *ctx, const pa_source_info *pinfo,
     return;
   info = pulse_info_from_idx(&pulse_interfaces[1], pinfo->index, TRUE);
 
-  g_free(info->name);
-  info->name = g_strdup(pinfo->name);
+  pulse_table_set_name(&pulse_interfaces[1].devices, info, pinfo->name);
   g_free(info->icon);
   info->icon = g_strdup(pa_proplist_gets(pinfo->proplist,
         PA_PROP_DEVICE_ICON_NAME));
@@ -403,7 +548,7 @@ static void pulse_source_cb ( pa_context *ctx, const pa_source_info *pinfo,
   info->idx = pinfo->index;
   info->cvol = pinfo->volume;
   info->mute = pinfo->mute;
-  trigger_emit("volume");
+  pulse_changed();
 }
 
 static void pulse_server_cb ( pa_context *ctx, const pa_server_info *info,
@@ -479,7 +624,7 @@ static void pulse_state_cb ( pa_context *ctx, gpointer data )
     pa_context_disconnect(ctx);
     pa_context_unref(ctx);
     module_interface_select(sfwbar_interface.interface);
-    trigger_emit("volume");
+    pulse_changed();
   }
   else if(state == PA_CONTEXT_READY)
   {
@@ -565,7 +710,8 @@ static void pulse_client_set_sink ( pulse_info *info, gchar *dest )
   while(*dest == ' ')
     dest++;
 
-  if( !(dinfo = pulse_addr_parse(dest, &pulse_interfaces[0], NULL)) )
+  if( !(dinfo = pulse_addr_parse(dest, &pulse_interfaces[0].devices,
+          pulse_interfaces[0].default_control, NULL)) )
     return;
 
   pulse_operation(pa_context_move_sink_input_by_index(pctx, info->idx,
@@ -574,10 +720,12 @@ static void pulse_client_set_sink ( pulse_info *info, gchar *dest )
 
 static value_t pulse_volume_func ( vm_t *vm, value_t p[], gint np )
 {
+  pulse_snapshot_t *snap;
   pulse_info *info;
   pulse_interface_t *iface;
+  value_t result;
   gchar *cmd;
-  gint cidx;
+  gint cidx, i;
 
   vm_param_check_np_range(vm, np, 1, 2, "Volume");
   vm_param_check_string(vm, p, 0, "Volume");
@@ -586,29 +734,40 @@ static value_t pulse_volume_func ( vm_t *vm, value_t p[], gint np )
 
   if( !(iface = pulse_interface_get(value_get_string(p[0]), &cmd)) )
     return value_na;
+  if( !(snap = pulse_snapshot_get()) )
+    return value_na;
+  i = iface - pulse_interfaces;
 
-  info = pulse_addr_parse(np==2? value_get_string(p[1]) : NULL, iface, &cidx);
+  info = pulse_addr_parse(np==2? value_get_string(p[1]) : NULL,
+      &snap->tables[i], snap->default_control[i], &cidx);
 
   if(info && !g_ascii_strcasecmp(cmd, "volume"))
-    return value_new_numeric(100.0*pulse_volume_get(info,cidx)/PA_VOLUME_NORM);
-  if(info && !g_ascii_strcasecmp(cmd, "mute"))
-    return value_new_numeric(info->mute);
-  if(!g_ascii_strcasecmp(cmd, "count"))
-    return value_new_numeric(g_list_length(iface->list));
-  if(info && !g_ascii_strcasecmp(cmd, "is-default-device"))
-    return value_new_numeric(!g_strcmp0(info->name, iface->default_device));
-  if(info && !g_ascii_strcasecmp(cmd, "is-default"))
-    return value_new_numeric(!g_strcmp0(info->name, iface->default_control));
+    result = value_new_numeric(
+        100.0*pulse_volume_get(info,cidx)/PA_VOLUME_NORM);
+  else if(info && !g_ascii_strcasecmp(cmd, "mute"))
+    result = value_new_numeric(info->mute);
+  else if(!g_ascii_strcasecmp(cmd, "count"))
+    result = value_new_numeric(g_hash_table_size(snap->tables[i].by_idx));
+  else if(info && !g_ascii_strcasecmp(cmd, "is-default-device"))
+    result = value_new_numeric(
+        !g_strcmp0(info->name, snap->default_device[i]));
+  else if(info && !g_ascii_strcasecmp(cmd, "is-default"))
+    result = value_new_numeric(
+        !g_strcmp0(info->name, snap->default_control[i]));
+  else
+    result = value_na;
 
-  return value_na;
+  pulse_snapshot_unref(snap);
+  return result;
 }
 
 static value_t pulse_volume_info_func ( vm_t *vm, value_t p[], gint np )
 {
+  pulse_snapshot_t *snap;
   pulse_info *info;
   pulse_interface_t *iface;
-  gchar *cmd;
-  gint cidx;
+  gchar *cmd, *str;
+  gint cidx, i;
 
   vm_param_check_np_range(vm, np, 1, 2, "VolumeInfo");
   vm_param_check_string(vm, p, 0, "VolumeInfo");
@@ -617,23 +776,32 @@ static value_t pulse_volume_info_func ( vm_t *vm, value_t p[], gint np )
 
   if( !(iface = pulse_interface_get(value_get_string(p[0]), &cmd)) )
     return value_na;
+  if( !(snap = pulse_snapshot_get()) )
+    return value_na;
+  i = iface - pulse_interfaces;
 
-  if( !(info = pulse_addr_parse(np==2? value_get_string(p[1]) : NULL, iface,
-          &cidx)) )
+  if( !(info = pulse_addr_parse(np==2? value_get_string(p[1]) : NULL,
+          &snap->tables[i], snap->default_control[i], &cidx)) )
+  {
+    pulse_snapshot_unref(snap);
     return value_na;
+  }
 
   if(!g_ascii_strcasecmp(cmd, "icon"))
-    return value_new_string(g_strdup(info->icon? info->icon : ""));
-  if(!g_ascii_strcasecmp(cmd, "form"))
-    return value_new_string(g_strdup(info->form? info->form : ""));
-  if(!g_ascii_strcasecmp(cmd, "port"))
-    return value_new_string(g_strdup(info->port? info->port : ""));
-  if(!g_ascii_strcasecmp(cmd, "monitor"))
-    return value_new_string(g_strdup(info->monitor? info->monitor : ""));
-  if(!g_ascii_strcasecmp(cmd, "description"))
-    return value_new_string(g_strdup(info->description? info->description:""));
+    str = g_strdup(info->icon? info->icon : "");
+  else if(!g_ascii_strcasecmp(cmd, "form"))
+    str = g_strdup(info->form? info->form : "");
+  else if(!g_ascii_strcasecmp(cmd, "port"))
+    str = g_strdup(info->port? info->port : "");
+  else if(!g_ascii_strcasecmp(cmd, "monitor"))
+    str = g_strdup(info->monitor? info->monitor : "");
+  else if(!g_ascii_strcasecmp(cmd, "description"))
+    str = g_strdup(info->description? info->description:"");
+  else
+    str = g_strdup_printf("invalid query: %s", cmd);
 
-  return value_new_string(g_strdup_printf("invalid query: %s", cmd));
+  pulse_snapshot_unref(snap);
+  return value_new_string(str);
 }
 
 static value_t pulse_volume_ctl_action ( vm_t *vm, value_t p[], gint np )
@@ -651,8 +819,8 @@ static value_t pulse_volume_ctl_action ( vm_t *vm, value_t p[], gint np )
   if( !(iface = pulse_interface_get(value_get_string(p[np-1]), &command)) )
     return value_na;
 
-  if( !(info = pulse_addr_parse(np==2? value_get_string(p[0]) : NULL, iface,
-          &cidx)) )
+  if( !(info = pulse_addr_parse(np==2? value_get_string(p[0]) : NULL,
+          &iface->devices, iface->default_control, &cidx)) )
     return value_na;
 
   if(!g_ascii_strncasecmp(command, "volume", 6))
@@ -679,11 +847,13 @@ static void pulse_activate ( void )
         PA_SUBSCRIPTION_MASK_SINK | PA_SUBSCRIPTION_MASK_SINK_INPUT |
         PA_SUBSCRIPTION_MASK_SOURCE | PA_SUBSCRIPTION_MASK_SOURCE_OUTPUT,
         NULL, NULL), "pa_context_subscribe");
-  trigger_emit("volume");
+  pulse_changed();
 }
 
 static void pulse_deactivate ( void )
 {
+  GHashTableIter hiter;
+  pulse_info *info;
   gint i;
 
   g_debug("pulse: deactivating");
@@ -691,9 +861,17 @@ static void pulse_deactivate ( void )
   pa_context_set_subscribe_callback(pctx, NULL, NULL);
 
   for(i=0; i<3; i++)
-      while(pulse_interfaces[i].list)
-        pulse_remove_device(&pulse_interfaces[i],
-            ((pulse_info *)pulse_interfaces[i].list->data)->idx);
+  {
+    g_hash_table_iter_init(&hiter, pulse_interfaces[i].devices.by_idx);
+    while(g_hash_table_iter_next(&hiter, NULL, (gpointer *)&info))
+      if(info->name)
+        trigger_emit_with_string("volume-conf-removed", "device_id",
+            g_strdup_printf("@pulse-%s-%d", pulse_interfaces[i].prefix,
+              info->idx));
+    g_hash_table_remove_all(pulse_interfaces[i].devices.by_name);
+    g_hash_table_remove_all(pulse_interfaces[i].devices.by_idx);
+  }
+  pulse_changed();
 
   sfwbar_interface.active = FALSE;
 }
@@ -710,6 +888,10 @@ static void pulse_finalize ( void )
 gboolean sfwbar_module_init ( void )
 {
   pa_glib_mainloop *ploop;
+  gint i;
+
+  for(i=0; i<3; i++)
+    pulse_table_init(&pulse_interfaces[i].devices);
 
   ploop = pa_glib_mainloop_new(g_main_context_get_thread_default());
   papi = pa_glib_mainloop_get_api(ploop);
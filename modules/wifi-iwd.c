@@ -841,13 +841,19 @@ static value_t iw_action_forget ( vm_t *vm, value_t p[], gint np )
   return value_na;
 }
 
+static ModuleFunctionV1 iw_functions[] = {
+  { "wifiget", iw_expr_get, MODULE_FUNC_PUSH,
+    (gchar *[]){ "wifi_updated", "wifi_removed", "wifi_level", "wifi_scan_complete", NULL } },
+  { "wifiscan", iw_action_scan, MODULE_FUNC_ACTION, NULL },
+  { "wificonnect", iw_action_connect, MODULE_FUNC_ACTION, NULL },
+  { "wifidisconnect", iw_action_disconnect, MODULE_FUNC_ACTION, NULL },
+  { "wififorget", iw_action_forget, MODULE_FUNC_ACTION, NULL },
+  { NULL }
+};
+
 static void iw_activate ( void )
 {
-  vm_func_add("wifiget", iw_expr_get, FALSE);
-  vm_func_add("wifiscan", iw_action_scan, TRUE);
-  vm_func_add("wificonnect", iw_action_connect, TRUE);
-  vm_func_add("wifidisconnect", iw_action_disconnect, TRUE);
-  vm_func_add("wififorget", iw_action_forget, TRUE);
+  module_functions_add(iw_functions);
   sub_add = g_dbus_connection_signal_subscribe(iw_con, iw_owner,
       "org.freedesktop.DBus.ObjectManager", "InterfacesAdded", NULL, NULL,
       G_DBUS_SIGNAL_FLAGS_NONE, iw_object_new_cb, NULL, NULL);
@@ -887,6 +893,7 @@ static void iw_finalize ( void )
   vm_func_remove("wificonnect");
   vm_func_remove("wifidisconnect");
   vm_func_remove("wififorget");
+  module_func_changed("wifiget");
 }
 
 gboolean sfwbar_module_init ( void )
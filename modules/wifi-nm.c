@@ -969,13 +969,19 @@ static value_t nm_action_forget ( vm_t *vm, value_t p[], gint np )
   return value_na;
 }
 
+static ModuleFunctionV1 nm_functions[] = {
+  { "wifiget", nm_expr_get, MODULE_FUNC_PUSH,
+    (gchar *[]){ "wifi_updated", "wifi_removed", "wifi", "wifi_scan_complete", NULL } },
+  { "wifiscan", nm_action_scan, MODULE_FUNC_ACTION, NULL },
+  { "wificonnect", nm_action_connect, MODULE_FUNC_ACTION, NULL },
+  { "wifidisconnect", nm_action_disconnect, MODULE_FUNC_ACTION, NULL },
+  { "wififorget", nm_action_forget, MODULE_FUNC_ACTION, NULL },
+  { NULL }
+};
+
 static void nm_activate ( void )
 {
-  vm_func_add("wifiget", nm_expr_get, FALSE);
-  vm_func_add("wifiscan", nm_action_scan, FALSE);
-  vm_func_add("wificonnect", nm_action_connect, FALSE);
-  vm_func_add("wifidisconnect", nm_action_disconnect, FALSE);
-  vm_func_add("wififorget", nm_action_forget, FALSE);
+  module_functions_add(nm_functions);
   sub_add = g_dbus_connection_signal_subscribe(nm_con, nm_owner,
       nm_iface_objmgr, "InterfacesAdded", NULL, NULL,
       G_DBUS_SIGNAL_FLAGS_NONE, nm_object_new, NULL, NULL);
@@ -1017,6 +1023,7 @@ static void nm_finalize ( void )
   vm_func_remove("wificonnect");
   vm_func_remove("wifidisconnect");
   vm_func_remove("wififorget");
+  module_func_changed("wifiget");
 }
 
 gboolean sfwbar_module_init ( void )
@@ -17,6 +17,18 @@
 #include "util/string.h"
 #include "vm/vm.h"
 
+/* widgets in popups and menus that were never shown don't exist yet */
+static GtkWidget *action_widget_from_id ( vm_store_t *store, gchar *id )
+{
+  GtkWidget *widget;
+
+  if( !(widget = base_widget_from_id(store, id)) &&
+      config_deferred_build_all() )
+    widget = base_widget_from_id(store, id);
+
+  return widget;
+}
+
 static value_t action_exec_impl ( vm_t *vm, value_t p[], gint np )
 {
   gint argc;
@@ -49,7 +61,7 @@ static value_t action_function ( vm_t *vm, value_t p[], gint np )
   if(np==2)
   {
     vm_param_check_string(vm, p, 1, "Function");
-    vm->widget = base_widget_from_id(vm->store, value_get_string(p[0]));
+    vm->widget = action_widget_from_id(vm->store, value_get_string(p[0]));
     vm->widget = vm->widget? vm->widget : widget;
   }
 
@@ -103,6 +115,8 @@ static value_t action_menuitemclear ( vm_t *vm, value_t p[], gint np )
   vm_param_check_np(vm, np, 1, "MenuClear");
   vm_param_check_string(vm, p, 0, "MenuClear");
 
+  /* the item may sit in a menu that hasn't been built yet */
+  config_deferred_build_all();
   menu_item_remove(value_get_string(p[0]));
   return value_na;
 }
@@ -327,7 +341,7 @@ static value_t action_setcode ( vm_t *vm, value_t p[], gint np, gchar *func,
     return value_na;
 
   mark = vm->pstack->pdata[vm->pstack->len-1];
-  widget = np==2? base_widget_from_id(vm->store, value_get_string(p[0])) :
+  widget = np==2? action_widget_from_id(vm->store, value_get_string(p[0])) :
         vm->widget;
   if(!widget)
     return value_na;
@@ -365,7 +379,7 @@ static value_t action_userstate ( vm_t *vm, value_t p[], gint np )
   if(np==2)
     vm_param_check_string(vm, p, 1, "UserState");
 
-  widget = np==2? base_widget_from_id(vm->store, value_get_string(p[0])) :
+  widget = np==2? action_widget_from_id(vm->store, value_get_string(p[0])) :
     vm->widget;
 
   if(!widget || !(value = value_get_string(p[np-1])) )
@@ -413,7 +427,7 @@ static window_t *action_window_get ( vm_t *vm, value_t p[], gint np )
   GtkWidget *widget;
 
   if(np==1 && value_is_string(p[0]))
-    widget = base_widget_from_id(vm->store, value_get_string(p[0]));
+    widget = action_widget_from_id(vm->store, value_get_string(p[0]));
   else
     widget = vm->widget;
 
@@ -529,7 +543,7 @@ static value_t action_clear_widget ( vm_t *vm, value_t p[], gint np )
   vm_param_check_np(vm, np, 1, "ClearWidget");
   vm_param_check_string(vm, p, 0, "ClearWidget");
 
-  if( (w = base_widget_from_id(vm->store, value_get_string(p[0]))) )
+  if( (w = action_widget_from_id(vm->store, value_get_string(p[0]))) )
     gtk_widget_destroy(w);
 
   return value_na;
@@ -552,7 +566,7 @@ static value_t action_workspace_activate ( vm_t *vm, value_t p[], gint np )
   GtkWidget *widget;
 
   if(np==1 && value_is_string(p[0]))
-    widget = base_widget_from_id(vm->store, value_get_string(p[0]));
+    widget = action_widget_from_id(vm->store, value_get_string(p[0]));
   else
     widget = vm->widget;
 
@@ -641,6 +655,17 @@ static value_t action_emit_trigger ( vm_t *vm, value_t p[], gint np )
   return value_na;
 }
 
+static value_t action_trigger_rate_limit ( vm_t *vm, value_t p[], gint np )
+{
+  vm_param_check_np(vm, np, 2, "TriggerRateLimit");
+  vm_param_check_string(vm, p, 0, "TriggerRateLimit");
+  vm_param_check_numeric(vm, p, 1, "TriggerRateLimit");
+
+  trigger_set_rate_limit(value_get_string(p[0]), value_get_numeric(p[1]));
+
+  return value_na;
+}
+
 static value_t action_dbus_call (GDBusConnection *con, vm_t *vm, value_t p[],
     gint np)
 {
@@ -703,13 +728,26 @@ static value_t action_update_widget ( vm_t *vm, value_t p[], gint np )
   if(np==1)
     vm_param_check_string(vm, p, 0, "UpdateWidget");
 
-  if( (widget = np? base_widget_from_id(vm->store, value_get_string(p[0])) :
+  if( (widget = np? action_widget_from_id(vm->store, value_get_string(p[0])) :
         vm->widget) )
     base_widget_update(widget, NULL);
 
   return value_na;
 }
 
+static value_t action_wakeup_quantum ( vm_t *vm, value_t p[], gint np )
+{
+  vm_param_check_np_range(vm, np, 1, 2, "SetWakeupQuantum");
+  vm_param_check_numeric(vm, p, 0, "SetWakeupQuantum");
+  if(np==2)
+    vm_param_check_numeric(vm, p, 1, "SetWakeupQuantum");
+
+  base_widget_scanner_set_quantum(value_get_numeric(p[0]),
+      value_get_numeric(p[np-1]));
+
+  return value_na;
+}
+
 void action_lib_init ( void )
 {
   vm_func_add("exec", action_exec_impl, TRUE);
@@ -750,8 +788,10 @@ void action_lib_init ( void )
   vm_func_add("checkstate", action_check_state, FALSE);
   vm_func_add("filetrigger", action_file_trigger, FALSE);
   vm_func_add("emittrigger", action_emit_trigger, FALSE);
+  vm_func_add("triggerratelimit", action_trigger_rate_limit, TRUE);
   vm_func_add("DbusCallSystem", action_dbus_call_system, TRUE);
   vm_func_add("DbusCallSession", action_dbus_call_session, TRUE);
   vm_func_add("exit", action_exit, TRUE);
   vm_func_add("UpdateWidget", action_update_widget, TRUE);
+  vm_func_add("SetWakeupQuantum", action_wakeup_quantum, TRUE);
 }
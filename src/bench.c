@@ -0,0 +1,48 @@
+/* This entire file is licensed under GNU General Public License v3.0
+ *
+ * Copyright 2025- sfwbar maintainers
+ */
+
+#include <stdlib.h>
+#include "bench.h"
+
+static gint allocs;
+
+#ifdef __GLIBC__
+extern void *__libc_malloc ( size_t );
+extern void *__libc_calloc ( size_t, size_t );
+extern void *__libc_realloc ( void *, size_t );
+
+void *malloc ( size_t size )
+{
+  g_atomic_int_inc(&allocs);
+  return __libc_malloc(size);
+}
+
+void *calloc ( size_t n, size_t size )
+{
+  g_atomic_int_inc(&allocs);
+  return __libc_calloc(n, size);
+}
+
+void *realloc ( void *ptr, size_t size )
+{
+  g_atomic_int_inc(&allocs);
+  return __libc_realloc(ptr, size);
+}
+
+gboolean bench_allocs_supported ( void )
+{
+  return TRUE;
+}
+#else
+gboolean bench_allocs_supported ( void )
+{
+  return FALSE;
+}
+#endif
+
+gint bench_allocs ( void )
+{
+  return g_atomic_int_get(&allocs);
+}
@@ -0,0 +1,11 @@
+#ifndef __SFWBAR_BENCH_H__
+#define __SFWBAR_BENCH_H__
+
+#include <glib.h>
+
+/* heap allocation counter for the benchmark tools. bench.c replaces the
+ * libc allocator entry points, so it must only be linked into tools */
+gboolean bench_allocs_supported ( void );
+gint bench_allocs ( void );
+
+#endif
@@ -307,3 +307,118 @@ void config_skip_statement ( GScanner *scanner )
     }
   }
 }
+
+typedef struct {
+  gchar *fname;
+  gchar *text;
+  guint line;
+  vm_store_t *store;
+  config_block_func parse;
+} config_block_t;
+
+static GHashTable *config_deferred;
+
+static void config_block_free ( config_block_t *block )
+{
+  g_free(block->fname);
+  g_free(block->text);
+  g_free(block);
+}
+
+static void config_deferred_free ( GList *blocks )
+{
+  g_list_free_full(blocks, (GDestroyNotify)config_block_free);
+}
+
+static void config_deferred_destroy ( gpointer data, GObject *widget )
+{
+  g_hash_table_remove(config_deferred, widget);
+}
+
+/* record the source of a '{ ... }' block and parse it into the widget when
+ * config_deferred_build is called on it, i.e. when a popup or a menu is
+ * shown for the first time */
+gboolean config_defer ( GScanner *scanner, GtkWidget *widget,
+    config_block_func parse )
+{
+  config_block_t *block;
+  const gchar *start;
+  GList *blocks;
+  guint line;
+  gint depth = 0;
+
+  if(g_scanner_peek_next_token(scanner) != '{')
+    return FALSE;
+
+  /* the peeked '{' is the last character consumed from the input */
+  start = scanner->text - 1;
+  line = scanner->next_line;
+  do
+  {
+    g_scanner_get_next_token(scanner);
+    if(scanner->token == '{')
+      depth++;
+    else if(scanner->token == '}')
+      depth--;
+  } while(depth && scanner->token != G_TOKEN_EOF);
+
+  block = g_malloc0(sizeof(config_block_t));
+  block->fname = g_strdup(scanner->input_name);
+  block->text = g_strndup(start, scanner->text - start);
+  block->line = line;
+  block->store = SCANNER_STORE(scanner);
+  block->parse = parse;
+
+  if(!config_deferred)
+    config_deferred = g_hash_table_new_full(g_direct_hash, g_direct_equal,
+        NULL, (GDestroyNotify)config_deferred_free);
+  if( (blocks = g_hash_table_lookup(config_deferred, widget)) )
+    blocks = g_list_append(blocks, block);
+  else
+  {
+    g_object_weak_ref(G_OBJECT(widget), config_deferred_destroy, NULL);
+    g_hash_table_insert(config_deferred, widget, g_list_append(NULL, block));
+  }
+
+  return TRUE;
+}
+
+void config_deferred_build ( GtkWidget *widget )
+{
+  config_block_t *block;
+  GScanner *scanner;
+  GList *blocks, *iter;
+
+  if(!config_deferred ||
+      !(blocks = g_hash_table_lookup(config_deferred, widget)))
+    return;
+
+  g_hash_table_steal(config_deferred, widget);
+  g_object_weak_unref(G_OBJECT(widget), config_deferred_destroy, NULL);
+
+  for(iter=blocks; iter; iter=g_list_next(iter))
+  {
+    block = iter->data;
+    scanner = config_scanner_new(block->fname, block->text, block->store);
+    scanner->line = block->line;
+    block->parse(scanner, widget);
+    config_scanner_free(scanner);
+  }
+  config_deferred_free(blocks);
+}
+
+/* build everything still pending, for lookups of widgets by id */
+gboolean config_deferred_build_all ( void )
+{
+  GList *widgets, *iter;
+
+  if(!config_deferred || !g_hash_table_size(config_deferred))
+    return FALSE;
+
+  widgets = g_hash_table_get_keys(config_deferred);
+  for(iter=widgets; iter; iter=g_list_next(iter))
+    config_deferred_build(iter->data);
+  g_list_free(widgets);
+
+  return TRUE;
+}
@@ -36,6 +36,7 @@ extern GHashTable *config_widget_keys, *config_prop_keys, *config_placer_keys;
 extern GHashTable *config_flowgrid_props, *config_menu_item_keys;
 
 typedef gboolean (*parse_func) ( GScanner *, void * );
+typedef void (*config_block_func) ( GScanner *, GtkWidget * );
 
 void config_init ( void );
 gpointer config_lookup_ptr ( GScanner *scanner, GHashTable *table );
@@ -44,6 +45,9 @@ gboolean config_check_and_consume ( GScanner *scanner, gint token );
 gchar *config_value_string ( gchar *dest, gchar *string );
 GtkWidget *config_parse ( gchar *, GtkWidget *, vm_store_t * );
 GtkWidget *config_parse_data ( gchar *, gchar *, GtkWidget *, vm_store_t *);
+GScanner *config_scanner_new ( gchar *fname, gchar *data,
+    vm_store_t *globals );
+void config_scanner_free ( GScanner *scanner );
 gboolean config_expect_token ( GScanner *scan, gint token, gchar *fmt, ...);
 gboolean config_is_section_end ( GScanner *scanner );
 void config_parse_sequence ( GScanner *scanner, ... );
@@ -73,6 +77,10 @@ GtkWidget *config_parse_toplevel ( GScanner *scanner, GtkWidget *container );
 void config_menu_clear ( GScanner *scanner );
 void config_menu ( GScanner *scanner );
 void config_skip_statement ( GScanner *scanner );
+gboolean config_defer ( GScanner *scanner, GtkWidget *widget,
+    config_block_func parse );
+void config_deferred_build ( GtkWidget *widget );
+gboolean config_deferred_build_all ( void );
 
 enum {
   G_TOKEN_SCANNER = G_TOKEN_LAST + 50,
@@ -96,6 +104,10 @@ enum {
   G_TOKEN_SWAYCLIENT,
   G_TOKEN_EXECCLIENT,
   G_TOKEN_SOCKETCLIENT,
+  G_TOKEN_PROCSTAT,
+  G_TOKEN_MEMINFO,
+  G_TOKEN_NETDEV,
+  G_TOKEN_DISKSTATS,
   G_TOKEN_NUMBERW,
   G_TOKEN_STRINGW,
   G_TOKEN_NOGLOB,
@@ -153,6 +153,10 @@ void config_init ( void )
   config_add_key(config_scanner_keys, "SwayClient", G_TOKEN_SWAYCLIENT);
   config_add_key(config_scanner_keys, "ExecClient", G_TOKEN_EXECCLIENT);
   config_add_key(config_scanner_keys, "SocketClient", G_TOKEN_SOCKETCLIENT);
+  config_add_key(config_scanner_keys, "ProcStat", G_TOKEN_PROCSTAT);
+  config_add_key(config_scanner_keys, "MemInfo", G_TOKEN_MEMINFO);
+  config_add_key(config_scanner_keys, "NetDev", G_TOKEN_NETDEV);
+  config_add_key(config_scanner_keys, "DiskStats", G_TOKEN_DISKSTATS);
 
   config_scanner_types = g_hash_table_new((GHashFunc)str_nhash,
       (GEqualFunc)str_nequal);
@@ -269,16 +273,10 @@ void config_log_error ( GScanner *scanner, gchar *message, gboolean error )
     g_message("%s:%d: %s", scanner->input_name, scanner->line, message);
 }
 
-GtkWidget *config_parse_data ( gchar *fname, gchar *data, GtkWidget *container,
-   vm_store_t *globals )
+GScanner *config_scanner_new ( gchar *fname, gchar *data,
+    vm_store_t *globals )
 {
   GScanner *scanner;
-  GtkWidget *w;
-  GtkCssProvider *css;
-  gchar *tmp;
-
-  if(!data)
-    return NULL;
 
   scanner = g_scanner_new(&scanner_config);
   while(globals && globals->transient)
@@ -292,12 +290,31 @@ GtkWidget *config_parse_data ( gchar *fname, gchar *data, GtkWidget *container,
   scanner->input_name = fname;
   g_scanner_input_text(scanner, data, strlen(data));
 
+  return scanner;
+}
+
+void config_scanner_free ( GScanner *scanner )
+{
+  g_free(scanner->user_data);
+  g_scanner_destroy(scanner);
+}
+
+GtkWidget *config_parse_data ( gchar *fname, gchar *data, GtkWidget *container,
+   vm_store_t *globals )
+{
+  GScanner *scanner;
+  GtkWidget *w;
+  GtkCssProvider *css;
+  gchar *tmp;
+
+  if(!data)
+    return NULL;
 
   if( (tmp = strstr(data, "\n#CSS")) )
     *tmp = 0;
+  scanner = config_scanner_new(fname, data, globals);
   w = config_parse_toplevel(scanner, container);
-  g_free(scanner->user_data);
-  g_scanner_destroy(scanner);
+  config_scanner_free(scanner);
 
   if(tmp)
   {
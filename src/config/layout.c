@@ -342,6 +342,7 @@ GtkWidget *config_layout ( GScanner *scanner, GtkWidget *container )
 
 void config_popup ( GScanner *scanner )
 {
+  GtkWidget *grid;
   gchar *id;
 
   config_parse_sequence(scanner,
@@ -350,8 +351,13 @@ void config_popup ( GScanner *scanner )
       SEQ_OPT, ')', NULL, NULL, NULL,
       SEQ_END);
 
+  /* popups are built when they are shown for the first time */
   if(!scanner->max_parse_errors && id)
-    config_widget(scanner, gtk_bin_get_child(GTK_BIN(popup_new(id))));
+  {
+    grid = gtk_bin_get_child(GTK_BIN(popup_new(id)));
+    if(!config_defer(scanner, grid, config_widget))
+      config_widget(scanner, grid);
+  }
 
   g_free(id);
 }
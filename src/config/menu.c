@@ -171,6 +171,12 @@ void config_menu_items ( GScanner *scanner, GtkWidget *menu )
   }
 }
 
+static void config_menu_block ( GScanner *scanner, GtkWidget *menu )
+{
+  if(config_check_and_consume(scanner, '{'))
+    config_menu_items(scanner, menu);
+}
+
 void config_menu ( GScanner *scanner )
 {
   gchar *name = NULL;
@@ -179,11 +185,12 @@ void config_menu ( GScanner *scanner )
       SEQ_REQ, '(', NULL, NULL, "missing '(' after 'menu'",
       SEQ_REQ, G_TOKEN_STRING, NULL, &name, "missing menu name",
       SEQ_REQ, ')', NULL, NULL, "missing ')' after 'menu'",
-      SEQ_REQ, '{', NULL, NULL, "missing '{' after 'menu'",
       SEQ_END);
 
-  if(!scanner->max_parse_errors && name)
-    config_menu_items(scanner, menu_new(name));
+  /* menus are built when they are popped up for the first time */
+  if(!scanner->max_parse_errors && name &&
+      !config_defer(scanner, menu_new(name), config_menu_block))
+    g_scanner_error(scanner, "missing '{' after 'menu'");
 
   g_free(name);
   config_check_and_consume(scanner, ';');
@@ -145,6 +145,22 @@ static ScanFile *config_source ( GScanner *scanner, gint source )
   return file;
 }
 
+static void config_source_native ( GScanner *scanner, gint source )
+{
+  gchar *prefix = NULL;
+
+  config_parse_sequence(scanner,
+      SEQ_REQ, '(', NULL, NULL, "Missing '(' after source",
+      SEQ_OPT, G_TOKEN_STRING, NULL, &prefix, NULL,
+      SEQ_REQ, ')', NULL, NULL, "Missing ')' after source",
+      SEQ_OPT, ';', NULL, NULL, NULL,
+      SEQ_END);
+
+  if(!scanner->max_parse_errors)
+    scanner_file_native_new(source, prefix);
+  g_free(prefix);
+}
+
 gboolean config_scanner_source ( GScanner *scanner )
 {
   switch(config_lookup_key(scanner, config_scanner_keys))
@@ -167,6 +183,18 @@ gboolean config_scanner_source ( GScanner *scanner )
     case G_TOKEN_SOCKETCLIENT:
       client_socket(config_source(scanner, SO_CLIENT));
       return TRUE;
+    case G_TOKEN_PROCSTAT:
+      config_source_native(scanner, SO_PROCSTAT);
+      return TRUE;
+    case G_TOKEN_MEMINFO:
+      config_source_native(scanner, SO_MEMINFO);
+      return TRUE;
+    case G_TOKEN_NETDEV:
+      config_source_native(scanner, SO_NETDEV);
+      return TRUE;
+    case G_TOKEN_DISKSTATS:
+      config_source_native(scanner, SO_DISKSTATS);
+      return TRUE;
   }
   return FALSE;
 }
@@ -120,7 +120,7 @@ static value_t expr_lib_extract( vm_t *vm, value_t p[], gint np )
   vm_param_check_string(vm, p, 0, "extract");
   vm_param_check_string(vm, p, 1, "extract");
 
-  if( !(regex = g_regex_new(value_get_string(p[1]), 0, 0, NULL)) )
+  if( !(regex = regex_cache_get(value_get_string(p[1]))) )
     return value_na;
 
   if(g_regex_match (regex, value_get_string(p[0]), 0, &match) && match)
@@ -172,36 +172,80 @@ static value_t expr_lib_pad ( vm_t *vm, value_t p[], gint np )
 }
 
 /* Get current time string */
+typedef struct _time_format {
+  GTimeZone *tz;
+  gint64 stamp;
+  gchar *result;
+} time_format_t;
+
+#define TIME_CACHE_SIZE 32
+
+static GHashTable *time_cache;
+static GMutex time_mutex;
+
+static void expr_lib_time_format_free ( time_format_t *fmt )
+{
+  g_time_zone_unref(fmt->tz);
+  g_free(fmt->result);
+  g_free(fmt);
+}
+
+/* keep a time zone and the last formatted string per (zone, format) pair,
+ * so repeated evaluations within a second don't rebuild either */
 static value_t expr_lib_time ( vm_t *vm, value_t p[], gint np )
 {
-  GTimeZone *tz;
+  time_format_t *fmt;
   GDateTime *time;
-  gchar *str;
+  gchar *format, *zone, *key;
+  value_t result;
 
   vm_param_check_np_range(vm, np, 0, 2, "time");
   if(np>0)
     vm_param_check_string(vm, p, 0, "time");
   if(np==2)
     vm_param_check_string(vm, p, 1, "time");
-  if(np<2)
-    time = g_date_time_new_now_local();
-  else
+
+  format = (np>0)? value_get_string(p[0]) : "%a %b %d %H:%M:%S %Y";
+  zone = (np==2)? value_get_string(p[1]) : NULL;
+
+  g_mutex_lock(&time_mutex);
+  if(!time_cache)
+    time_cache = g_hash_table_new_full(g_str_hash, g_str_equal, g_free,
+        (GDestroyNotify)expr_lib_time_format_free);
+
+  key = g_strconcat(zone? zone : "", "\n", format, NULL);
+  if( !(fmt = g_hash_table_lookup(time_cache, key)) )
   {
+    if(g_hash_table_size(time_cache) >= TIME_CACHE_SIZE)
+      g_hash_table_remove_all(time_cache);
+    fmt = g_malloc0(sizeof(time_format_t));
+    if(!zone)
+      fmt->tz = g_time_zone_new_local();
 #if GLIB_MAJOR_VERSION == 2 && GLIB_MINOR_VERSION >= 68
-    if( !(tz = g_time_zone_new_identifier(value_get_string(p[1]))) )
-      tz = g_time_zone_new_utc();
+    else if( !(fmt->tz = g_time_zone_new_identifier(zone)) )
+      fmt->tz = g_time_zone_new_utc();
 #else
-    tz = g_time_zone_new(value_get_string(p[1]));
+    else
+      fmt->tz = g_time_zone_new(zone);
 #endif
-    time = g_date_time_new_now(tz);
-    g_time_zone_unref(tz);
+    fmt->stamp = -1;
+    g_hash_table_insert(time_cache, key, fmt);
   }
+  else
+    g_free(key);
 
-  str = g_date_time_format (time, (np>0)? value_get_string(p[0]) :
-      "%a %b %d %H:%M:%S %Y" );
-  g_date_time_unref(time);
+  if(fmt->stamp != g_get_real_time() / G_USEC_PER_SEC || strstr(format, "%f"))
+  {
+    time = g_date_time_new_now(fmt->tz);
+    g_free(fmt->result);
+    fmt->result = g_date_time_format(time, format);
+    fmt->stamp = g_date_time_to_unix(time);
+    g_date_time_unref(time);
+  }
+  result = value_new_string(g_strdup(fmt->result));
+  g_mutex_unlock(&time_mutex);
 
-  return value_new_string(str);
+  return result;
 }
 
 static value_t expr_lib_elapsed_str ( vm_t *vm, value_t p[], gint np )
@@ -255,6 +299,11 @@ static value_t expr_lib_disk ( vm_t *vm, value_t p[], gint np )
   return value_na;
 }
 
+static value_t expr_lib_wakeups ( vm_t *vm, value_t p[], gint np )
+{
+  return value_new_numeric(base_widget_scanner_get_wakeups());
+}
+
 static value_t expr_lib_active ( vm_t *vm, value_t p[], gint np )
 {
   return value_new_string(g_strdup(wintree_get_active()));
@@ -554,16 +603,16 @@ static value_t expr_array_index ( vm_t *vm, value_t p[], gint np )
   vm_param_check_numeric(vm, p, 1, "ArrayIndex");
 
   if(!value_is_array(p[0]) || (gint)value_get_numeric(p[1])<0 ||
-      p[0].value.array->len <= ((gint)value_get_numeric(p[1])))
+      value_get_array(p[0])->len <= ((gint)value_get_numeric(p[1])))
   return value_na;
 
-  return g_array_index(p[0].value.array, value_t,
-      (gint)value_get_numeric(p[1]));
+  return value_dup(g_array_index(value_get_array(p[0]), value_t,
+      (gint)value_get_numeric(p[1])));
 }
 
 static value_t expr_array_assign ( vm_t *vm, value_t p[], gint np )
 {
-  value_t *v1;
+  value_t *v1, result;
   GArray *arr;
   gint n;
 
@@ -574,7 +623,11 @@ static value_t expr_array_assign ( vm_t *vm, value_t p[], gint np )
   if(!value_is_array(p[0]))
     return value_na;
 
-  arr = g_array_ref(p[0].value.array);
+  /* take over the stack's reference, so an unshared array is updated in
+   * place */
+  result = p[0];
+  p[0] = value_na;
+  arr = value_array_writable(&result);
   n = (gint)value_get_numeric(p[1]);
   if(n<0 || n>=arr->len)
     g_array_set_size(arr, n+1);
@@ -583,7 +636,7 @@ static value_t expr_array_assign ( vm_t *vm, value_t p[], gint np )
   value_free(*v1);
   *v1 = value_dup(p[2]);
 
-  return value_new_array(arr);
+  return result;
 }
 
 static value_t expr_array_concat ( vm_t *vm, value_t p[], gint np )
@@ -597,7 +650,7 @@ static value_t expr_array_size ( vm_t *vm, value_t p[], gint np )
 {
   vm_param_check_np(vm, np, 1, "ArraySize");
 
-  return value_new_numeric(value_is_array(p[0])? p[0].value.array->len : 0);
+  return value_new_numeric(value_is_array(p[0])? value_get_array(p[0])->len : 0);
 }
 
 static value_t expr_test_file ( vm_t *vm, value_t p[], gint np )
@@ -668,26 +721,27 @@ static value_t expr_ls ( vm_t *vm, value_t p[], gint np )
 void expr_lib_init ( void )
 {
   vm_func_init();
-  vm_func_add("mid", expr_lib_mid, TRUE);
-  vm_func_add("pad", expr_lib_pad, TRUE);
-  vm_func_add("extract", expr_lib_extract, TRUE);
+  vm_func_add("mid", expr_lib_mid, VM_FUNC_MEMOIZE);
+  vm_func_add("pad", expr_lib_pad, VM_FUNC_MEMOIZE);
+  vm_func_add("extract", expr_lib_extract, VM_FUNC_MEMOIZE);
   vm_func_add("ident", expr_ident, TRUE);
-  vm_func_add("replace", expr_lib_replace, TRUE);
-  vm_func_add("replaceall", expr_lib_replace_all, TRUE);
-  vm_func_add("map", expr_lib_map, TRUE);
-  vm_func_add("lookup", expr_lib_lookup, TRUE);
+  vm_func_add("replace", expr_lib_replace, VM_FUNC_MEMOIZE);
+  vm_func_add("replaceall", expr_lib_replace_all, VM_FUNC_MEMOIZE);
+  vm_func_add("map", expr_lib_map, VM_FUNC_MEMOIZE);
+  vm_func_add("lookup", expr_lib_lookup, VM_FUNC_MEMOIZE);
   vm_func_add("time", expr_lib_time, FALSE);
-  vm_func_add("elapsedstr", expr_lib_elapsed_str, TRUE);
+  vm_func_add("elapsedstr", expr_lib_elapsed_str, VM_FUNC_MEMOIZE);
   vm_func_add("getlocale", expr_lib_getlocale, FALSE);
   vm_func_add("disk", expr_lib_disk, FALSE);
   vm_func_add("activewin", expr_lib_active, FALSE);
-  vm_func_add("max", expr_lib_max, TRUE);
-  vm_func_add("min", expr_lib_min, TRUE);
-  vm_func_add("val", expr_lib_val, TRUE);
-  vm_func_add("str", expr_lib_str, TRUE);
-  vm_func_add("upper", expr_lib_upper, TRUE);
-  vm_func_add("lower", expr_lib_lower, TRUE);
-  vm_func_add("escape", expr_lib_escape, TRUE);
+  vm_func_add("wakeuprate", expr_lib_wakeups, FALSE);
+  vm_func_add("max", expr_lib_max, VM_FUNC_MEMOIZE);
+  vm_func_add("min", expr_lib_min, VM_FUNC_MEMOIZE);
+  vm_func_add("val", expr_lib_val, VM_FUNC_MEMOIZE);
+  vm_func_add("str", expr_lib_str, VM_FUNC_MEMOIZE);
+  vm_func_add("upper", expr_lib_upper, VM_FUNC_MEMOIZE);
+  vm_func_add("lower", expr_lib_lower, VM_FUNC_MEMOIZE);
+  vm_func_add("escape", expr_lib_escape, VM_FUNC_MEMOIZE);
   vm_func_add("bardir", expr_lib_bardir, FALSE);
   vm_func_add("gtkevent", expr_lib_gtkevent, FALSE);
   vm_func_add("widgetid", expr_lib_widget_id, FALSE);
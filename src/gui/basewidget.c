@@ -3,6 +3,9 @@
  * Copyright 2022- sfwbar maintainers
  */
 
+#ifdef __linux__
+#include <sys/prctl.h>
+#endif
 #include "trigger.h"
 #include "module.h"
 #include "meson.h"
@@ -29,11 +32,22 @@ enum {
   BASE_WIDGET_LOC,
   BASE_WIDGET_TRIGGER,
   BASE_WIDGET_INTERVAL,
+  BASE_WIDGET_ALIGN,
+  BASE_WIDGET_BACKOFF,
   BASE_WIDGET_DISABLE,
 };
 
 static GList *widgets_scan;
 static GMutex widget_mutex;
+static GMutex scanner_mutex;
+static GCond scanner_cond;
+static gboolean scanner_wake;
+static gint64 scanner_quantum[2];
+static gint64 scanner_power_check;
+static gboolean scanner_battery;
+static gint scanner_wakeups;
+static gint64 scanner_wakeup_stamp;
+static gdouble scanner_wakeup_rate;
 static gint64 base_widget_default_id = 0;
 
 static void base_widget_attachment_free ( base_widget_attachment_t *attach )
@@ -77,20 +91,122 @@ static gboolean base_widget_style ( GtkWidget *self )
   return FALSE;
 }
 
-static void base_widget_update_expressions ( GtkWidget *self )
+static gboolean base_widget_eval_expressions ( GtkWidget *self )
 {
   BaseWidgetPrivate *priv;
+  GList *iter;
+  gboolean changed = FALSE;
 
-  g_return_if_fail(IS_BASE_WIDGET(self));
+  g_return_val_if_fail(IS_BASE_WIDGET(self), FALSE);
   priv = base_widget_get_instance_private(BASE_WIDGET(self));
 
-  if(expr_cache_eval(priv->value) || BASE_WIDGET_GET_CLASS(self)->always_update)
+  if(expr_cache_eval(priv->value))
+    changed = TRUE;
+  if(changed || BASE_WIDGET_GET_CLASS(self)->always_update)
     g_main_context_invoke(NULL, (GSourceFunc)base_widget_update_value, self);
   if(expr_cache_eval(priv->style))
+  {
+    changed = TRUE;
     g_main_context_invoke(NULL, (GSourceFunc)base_widget_style, self);
+  }
   if(priv->local_state)
-    g_list_foreach(priv->mirror_children,
-        (GFunc)base_widget_update_expressions, NULL);
+    for(iter=priv->mirror_children; iter; iter=g_list_next(iter))
+      changed |= base_widget_eval_expressions(iter->data);
+
+  return changed;
+}
+
+static void base_widget_update_expressions ( GtkWidget *self )
+{
+  base_widget_eval_expressions(self);
+}
+
+/* a widget is suspended if it and all its mirrors sit in unmapped windows */
+static gboolean base_widget_is_suspended ( GtkWidget *self )
+{
+  BaseWidgetPrivate *priv;
+  GList *iter;
+
+  priv = base_widget_get_instance_private(BASE_WIDGET(self));
+  if(!priv->suspended)
+    return FALSE;
+
+  for(iter=priv->mirror_children; iter; iter=g_list_next(iter))
+    if(!((BaseWidgetPrivate *)base_widget_get_instance_private(
+            BASE_WIDGET(iter->data)))->suspended)
+      return FALSE;
+
+  return TRUE;
+}
+
+/* refresh any values that went stale while the window was hidden. The
+ * scanner thread does the update, evaluating here would race with it on
+ * the same expressions */
+static void base_widget_toplevel_map ( GtkWidget *toplevel, GtkWidget *self )
+{
+  BaseWidgetPrivate *priv, *ppriv;
+  GtkWidget *parent;
+
+  priv = base_widget_get_instance_private(BASE_WIDGET(self));
+  if(!priv->suspended)
+    return;
+
+  parent = base_widget_get_mirror_parent(self);
+  ppriv = base_widget_get_instance_private(BASE_WIDGET(parent));
+  g_mutex_lock(&widget_mutex);
+  priv->suspended = FALSE;
+  ppriv->step = 0;
+  ppriv->next_poll = 0;
+  g_mutex_unlock(&widget_mutex);
+
+  base_widget_scanner_wake();
+}
+
+static void base_widget_toplevel_unmap ( GtkWidget *toplevel,
+    GtkWidget *self )
+{
+  BaseWidgetPrivate *priv;
+
+  priv = base_widget_get_instance_private(BASE_WIDGET(self));
+  g_mutex_lock(&widget_mutex);
+  priv->suspended = TRUE;
+  g_mutex_unlock(&widget_mutex);
+}
+
+/* track the mapped state of our window rather than our own, so widgets
+ * hidden by their style keep polling and can reappear */
+static void base_widget_hierarchy_changed ( GtkWidget *self, GtkWidget *prev )
+{
+  BaseWidgetPrivate *priv;
+  GtkWidget *toplevel;
+
+  g_return_if_fail(IS_BASE_WIDGET(self));
+  priv = base_widget_get_instance_private(BASE_WIDGET(self));
+
+  if(GTK_WIDGET_CLASS(base_widget_parent_class)->hierarchy_changed)
+    GTK_WIDGET_CLASS(base_widget_parent_class)->hierarchy_changed(self, prev);
+
+  if(prev)
+  {
+    g_signal_handlers_disconnect_by_func(prev,
+        G_CALLBACK(base_widget_toplevel_map), self);
+    g_signal_handlers_disconnect_by_func(prev,
+        G_CALLBACK(base_widget_toplevel_unmap), self);
+  }
+
+  toplevel = gtk_widget_get_toplevel(self);
+  if(gtk_widget_is_toplevel(toplevel))
+  {
+    g_signal_connect_object(toplevel, "map",
+        G_CALLBACK(base_widget_toplevel_map), self, G_CONNECT_AFTER);
+    g_signal_connect_object(toplevel, "unmap",
+        G_CALLBACK(base_widget_toplevel_unmap), self, 0);
+  }
+
+  g_mutex_lock(&widget_mutex);
+  priv->suspended = gtk_widget_is_toplevel(toplevel) &&
+    !gtk_widget_get_mapped(toplevel);
+  g_mutex_unlock(&widget_mutex);
 }
 
 static void base_widget_destroy ( GtkWidget *self )
@@ -411,10 +527,8 @@ static void base_widget_set_tooltip ( GtkWidget *self, GBytes *code )
   g_return_if_fail(IS_BASE_WIDGET(self));
   priv = base_widget_get_instance_private(BASE_WIDGET(self));
 
-  g_bytes_unref(priv->tooltip->code);
-  priv->tooltip->code = code? g_bytes_ref(code) : NULL;
+  expr_cache_set_code(priv->tooltip, code);
   priv->tooltip->widget = self;
-  priv->tooltip->eval = !!code;
 
   if(!BASE_WIDGET_GET_CLASS(self)->custom_tooltip)
   {
@@ -432,10 +546,8 @@ static void base_widget_set_value ( GtkWidget *self, GBytes *code )
 
   if(priv->value->code == code)
     return;
-  g_bytes_unref(priv->value->code);
-  priv->value->code = code? g_bytes_ref(code) : NULL;
+  expr_cache_set_code(priv->value, code);
   priv->value->widget = self;
-  priv->value->eval = !!code;
 
   if(expr_cache_eval(priv->value) || BASE_WIDGET_GET_CLASS(self)->always_update)
     base_widget_update_value(self);
@@ -444,6 +556,7 @@ static void base_widget_set_value ( GtkWidget *self, GBytes *code )
   if(!g_list_find(widgets_scan, self))
     widgets_scan = g_list_append(widgets_scan, self);
   g_mutex_unlock(&widget_mutex);
+  base_widget_scanner_wake();
 }
 
 static void base_widget_set_style ( GtkWidget *self, GBytes *code )
@@ -456,10 +569,8 @@ static void base_widget_set_style ( GtkWidget *self, GBytes *code )
 
   if(priv->style->code == code)
     return;
-  g_bytes_unref(priv->style->code);
-  priv->style->code = code? g_bytes_ref(code) : NULL;
+  expr_cache_set_code(priv->style, code);
   priv->style->widget = self;
-  priv->style->eval = !!code;
 
   if((priv->mirror_parent && !priv->local_state) ||
       expr_cache_eval(priv->style))
@@ -469,6 +580,7 @@ static void base_widget_set_style ( GtkWidget *self, GBytes *code )
   if(!g_list_find(widgets_scan, self))
     widgets_scan = g_list_append(widgets_scan, self);
   g_mutex_unlock(&widget_mutex);
+  base_widget_scanner_wake();
 }
 
 static void base_widget_set_rect ( GtkWidget *self, GdkRectangle *rect )
@@ -535,6 +647,12 @@ static void base_widget_get_property ( GObject *self, guint id, GValue *value,
     case BASE_WIDGET_INTERVAL:
       g_value_set_int64(value, priv->interval/1000);
       break;
+    case BASE_WIDGET_ALIGN:
+      g_value_set_boolean(value, priv->align);
+      break;
+    case BASE_WIDGET_BACKOFF:
+      g_value_set_int64(value, priv->backoff/1000);
+      break;
     case BASE_WIDGET_CSS:
       g_value_set_string(value, priv->css);
       break;
@@ -630,6 +748,15 @@ static void base_widget_set_property ( GObject *self, guint id,
       break;
     case BASE_WIDGET_INTERVAL:
       priv->interval = g_value_get_int64(value)*1000;
+      priv->step = 0;
+      break;
+    case BASE_WIDGET_ALIGN:
+      priv->align = g_value_get_boolean(value);
+      priv->next_poll = 0;
+      break;
+    case BASE_WIDGET_BACKOFF:
+      priv->backoff = g_value_get_int64(value)*1000;
+      priv->step = 0;
       break;
     case BASE_WIDGET_CSS:
       if(g_strcmp0(priv->css, g_value_get_string(value)))
@@ -661,6 +788,8 @@ static void base_widget_class_init ( BaseWidgetClass *kclass )
 
   GTK_WIDGET_CLASS(kclass)->destroy = base_widget_destroy;
   GTK_WIDGET_CLASS(kclass)->size_allocate = base_widget_size_allocate;
+  GTK_WIDGET_CLASS(kclass)->hierarchy_changed =
+    base_widget_hierarchy_changed;
   GTK_WIDGET_CLASS(kclass)->get_preferred_width = base_widget_get_pref_width;
   GTK_WIDGET_CLASS(kclass)->get_preferred_height = base_widget_get_pref_height;
   GTK_WIDGET_CLASS(kclass)->button_release_event =
@@ -701,6 +830,12 @@ static void base_widget_class_init ( BaseWidgetClass *kclass )
   g_object_class_install_property(G_OBJECT_CLASS(kclass), BASE_WIDGET_INTERVAL,
       g_param_spec_int64("interval", "interval", "sfwbar_config",
         0, INT64_MAX, 0, G_PARAM_READWRITE));
+  g_object_class_install_property(G_OBJECT_CLASS(kclass), BASE_WIDGET_ALIGN,
+      g_param_spec_boolean("align", "align", "sfwbar_config", FALSE,
+        G_PARAM_READWRITE));
+  g_object_class_install_property(G_OBJECT_CLASS(kclass), BASE_WIDGET_BACKOFF,
+      g_param_spec_int64("backoff", "backoff", "sfwbar_config",
+        0, INT64_MAX, 0, G_PARAM_READWRITE));
   g_object_class_install_property(G_OBJECT_CLASS(kclass),
       BASE_WIDGET_USER_STATE, g_param_spec_uint("user-state",
         "user-state", "no_config", 0, UINT_MAX, 0, G_PARAM_READWRITE));
@@ -833,6 +968,7 @@ gchar *base_widget_get_id ( GtkWidget *self )
 void base_widget_set_next_poll ( GtkWidget *self, gint64 ctime )
 {
   BaseWidgetPrivate *priv;
+  gint64 offset, step;
 
   g_return_if_fail(IS_BASE_WIDGET(self));
   priv = base_widget_get_instance_private(BASE_WIDGET(self));
@@ -840,8 +976,18 @@ void base_widget_set_next_poll ( GtkWidget *self, gint64 ctime )
   if(priv->trigger)
     return;
 
-  while(priv->next_poll <= ctime)
-    priv->next_poll += priv->interval;
+  /* wake up on the next multiple of interval in wall clock time */
+  if(priv->align && priv->interval)
+  {
+    offset = g_get_real_time() - g_get_monotonic_time();
+    priv->next_poll = ((ctime + offset) / priv->interval + 1) *
+      priv->interval - offset;
+    return;
+  }
+
+  step = MAX(priv->step, priv->interval);
+  if(step && priv->next_poll <= ctime)
+    priv->next_poll += ((ctime - priv->next_poll) / step + 1) * step;
 }
 
 gint64 base_widget_get_next_poll ( GtkWidget *self )
@@ -854,7 +1000,11 @@ gint64 base_widget_get_next_poll ( GtkWidget *self )
   if(priv->trigger || !priv->interval)
     return G_MAXINT64;
 
-  if(!priv->value->eval && !priv->style->eval)
+  if(!expr_cache_needs_poll(priv->value) &&
+      !expr_cache_needs_poll(priv->style))
+    return G_MAXINT64;
+
+  if(base_widget_is_suspended(self))
     return G_MAXINT64;
 
   return priv->next_poll;
@@ -1001,39 +1151,182 @@ GtkWidget *base_widget_get_mirror_parent ( GtkWidget *self )
     return self;
 }
 
+/* double the polling step while the output is stable, up to the backoff
+ * cap, and snap back to the configured interval on the first change */
+static void base_widget_backoff ( GtkWidget *self, gboolean changed )
+{
+  BaseWidgetPrivate *priv;
+
+  priv = base_widget_get_instance_private(BASE_WIDGET(self));
+
+  if(changed || priv->backoff <= priv->interval || priv->align)
+    priv->step = 0;
+  else
+    priv->step = MIN(MAX(priv->step, priv->interval) * 2, priv->backoff);
+}
+
 gint64 base_widget_update ( GtkWidget *self, gint64 *ctime )
 {
+  gboolean changed;
+
+  g_return_val_if_fail(IS_BASE_WIDGET(self), G_MAXINT64);
+
   if(!ctime || base_widget_get_next_poll(self) <= *ctime)
   {
-    base_widget_update_expressions(self);
+    changed = base_widget_eval_expressions(self);
     if(ctime)
+    {
+      base_widget_backoff(self, changed);
       base_widget_set_next_poll(self, *ctime);
+    }
   }
 
   return base_widget_get_next_poll(self);
 }
 
+void base_widget_scanner_wake ( void )
+{
+  g_mutex_lock(&scanner_mutex);
+  scanner_wake = TRUE;
+  g_cond_signal(&scanner_cond);
+  g_mutex_unlock(&scanner_mutex);
+}
+
+void base_widget_scanner_set_quantum ( gint64 ac, gint64 battery )
+{
+  g_mutex_lock(&scanner_mutex);
+  scanner_quantum[0] = MAX(ac, 0) * 1000;
+  scanner_quantum[1] = MAX(battery, 0) * 1000;
+  scanner_power_check = 0;
+  g_mutex_unlock(&scanner_mutex);
+  base_widget_scanner_wake();
+}
+
+gdouble base_widget_scanner_get_wakeups ( void )
+{
+  gdouble rate;
+
+  g_mutex_lock(&scanner_mutex);
+  rate = scanner_wakeup_rate;
+  g_mutex_unlock(&scanner_mutex);
+
+  return rate;
+}
+
+/* we are on battery if there is a mains supply and none of them is online */
+static gboolean base_widget_on_battery ( void )
+{
+  GDir *dir;
+  const gchar *name;
+  gchar *path, *type, *online;
+  gboolean mains = FALSE, on_line = FALSE;
+
+  if( !(dir = g_dir_open("/sys/class/power_supply", 0, NULL)) )
+    return FALSE;
+
+  while( (name = g_dir_read_name(dir)) && !on_line )
+  {
+    path = g_build_filename("/sys/class/power_supply", name, "type", NULL);
+    if(g_file_get_contents(path, &type, NULL, NULL))
+    {
+      if(g_str_has_prefix(type, "Mains"))
+      {
+        mains = TRUE;
+        g_free(path);
+        path = g_build_filename("/sys/class/power_supply", name, "online",
+            NULL);
+        if(g_file_get_contents(path, &online, NULL, NULL))
+        {
+          on_line = (*online == '1');
+          g_free(online);
+        }
+      }
+      g_free(type);
+    }
+    g_free(path);
+  }
+  g_dir_close(dir);
+
+  return mains && !on_line;
+}
+
+/* pick the wakeup quantum for the current power source and tell the kernel
+ * it can slack our timers by as much */
+static gint64 base_widget_scanner_quantum ( gint64 ctime )
+{
+  gint64 quantum;
+  gboolean battery;
+
+  g_mutex_lock(&scanner_mutex);
+  if(ctime >= scanner_power_check)
+  {
+    scanner_power_check = ctime + 10 * G_USEC_PER_SEC;
+    battery = (scanner_quantum[0] != scanner_quantum[1]) &&
+      base_widget_on_battery();
+    if(battery != scanner_battery)
+      g_debug("scanner: switching to %s wakeup policy",
+          battery? "battery" : "ac");
+    scanner_battery = battery;
+#ifdef __linux__
+    prctl(PR_SET_TIMERSLACK, scanner_quantum[battery]?
+        (unsigned long)scanner_quantum[battery] * 1000 / 4 : 0, 0, 0, 0);
+#endif
+  }
+  quantum = scanner_quantum[scanner_battery];
+
+  scanner_wakeups++;
+  if(ctime - scanner_wakeup_stamp >= 10 * G_USEC_PER_SEC)
+  {
+    if(scanner_wakeup_stamp)
+      scanner_wakeup_rate = (gdouble)scanner_wakeups * G_USEC_PER_SEC /
+        (ctime - scanner_wakeup_stamp);
+    scanner_wakeup_stamp = ctime;
+    scanner_wakeups = 0;
+  }
+  g_mutex_unlock(&scanner_mutex);
+
+  return quantum;
+}
+
 gpointer base_widget_scanner_thread ( GMainContext *gmc )
 {
+  BaseWidgetPrivate *priv;
   GList *iter;
-  gint64 timer, ctime;
+  gint64 timer, atimer, next, ctime, quantum;
 
   while ( TRUE )
   {
     scanner_invalidate();
     module_invalidate_all();
     timer = G_MAXINT64;
+    atimer = G_MAXINT64;
     ctime = g_get_monotonic_time();
+    quantum = base_widget_scanner_quantum(ctime);
    
     g_mutex_lock(&widget_mutex);
     for(iter=widgets_scan; iter!=NULL; iter=g_list_next(iter))
-      timer = MIN(timer, base_widget_update(iter->data, &ctime));
+    {
+      next = base_widget_update(iter->data, &ctime);
+      priv = base_widget_get_instance_private(BASE_WIDGET(iter->data));
+      if(priv->align)
+        atimer = MIN(atimer, next);
+      else
+        timer = MIN(timer, next);
+    }
     g_mutex_unlock(&widget_mutex);
 
-    timer -= g_get_monotonic_time();
-
-    if(timer > 0)
-      g_usleep(timer);
+    /* batch all deadlines falling into the same quantum into one wakeup.
+     * Aligned widgets are due on wall clock boundaries, don't delay them */
+    if(quantum && timer != G_MAXINT64)
+      timer = (timer + quantum - 1) / quantum * quantum;
+    timer = MIN(timer, atimer);
+
+    g_mutex_lock(&scanner_mutex);
+    while(!scanner_wake && timer > g_get_monotonic_time())
+      if(!g_cond_wait_until(&scanner_cond, &scanner_mutex, timer))
+        break;
+    scanner_wake = FALSE;
+    g_mutex_unlock(&scanner_mutex);
   }
 }
 
@@ -46,10 +46,14 @@ struct _BaseWidgetPrivate
   GList *actions;
   gint64 interval;
   gint64 next_poll;
+  gint64 backoff;
+  gint64 step;
   guint maxw, maxh;
   const gchar *trigger;
   gint dir;
   gboolean local_state;
+  gboolean align;
+  gboolean suspended;
   gboolean is_drag_dest;
   gboolean disabled;
   guint user_state;
@@ -84,6 +88,9 @@ GtkWidget *base_widget_from_id ( vm_store_t *store, gchar *id );
 gchar *base_widget_get_value ( GtkWidget *self );
 GBytes *base_widget_get_action ( GtkWidget *self, gint, GdkModifierType );
 gpointer base_widget_scanner_thread ( GMainContext *gmc );
+void base_widget_scanner_wake ( void );
+void base_widget_scanner_set_quantum ( gint64 ac, gint64 battery );
+gdouble base_widget_scanner_get_wakeups ( void );
 guint16 base_widget_state_build ( GtkWidget *self, window_t *win );
 //void base_widget_set_css ( GtkWidget *widget, gchar *css );
 void base_widget_autoexec ( GtkWidget *self, gpointer data );
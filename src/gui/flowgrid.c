@@ -9,6 +9,8 @@
 #include "window.h"
 #include "gui/bar.h"
 
+#define FLOW_GRID_POOL_SIZE 16
+
 G_DEFINE_TYPE_WITH_CODE (FlowGrid, flow_grid, BASE_WIDGET_TYPE,
     G_ADD_PRIVATE(FlowGrid))
 
@@ -25,6 +27,12 @@ enum {
   FLOW_GRID_TOOLTIP_OVERRIDE,
 };
 
+typedef struct _flow_grid_slot {
+  GSequenceIter *iter;
+  gint pos;
+  gboolean touched;
+} flow_grid_slot_t;
+
 GEnumValue flow_grid_axis[] = {
   { FLOW_GRID_AXIS_DEFAULT, "default", "default" },
   { FLOW_GRID_AXIS_ROWS, "rows", "rows" },
@@ -61,16 +69,31 @@ static void flow_grid_get_preferred_height (GtkWidget *self, gint *minimal,
     *minimal = MIN(*natural, 1);
 }
 
+static void flow_grid_pool_free ( GtkWidget *child )
+{
+  gtk_widget_destroy(child);
+  g_object_unref(child);
+}
+
 static void flow_grid_destroy( GtkWidget *self )
 {
   FlowGridPrivate *priv;
+  GSequence *children;
 
   g_return_if_fail(IS_FLOW_GRID(self));
   priv = flow_grid_get_instance_private(FLOW_GRID(self));
 
   g_clear_pointer(&priv->dnd_target, gtk_target_entry_free);
-  g_list_free_full(g_steal_pointer(&priv->children),
-      (GDestroyNotify)gtk_widget_destroy);
+  if( (children = g_steal_pointer(&priv->children)) )
+  {
+    g_sequence_foreach(children, (GFunc)gtk_widget_destroy, NULL);
+    g_sequence_free(children);
+  }
+  g_clear_pointer(&priv->slots, g_hash_table_destroy);
+  g_clear_pointer(&priv->dirty, g_hash_table_destroy);
+  g_clear_pointer(&priv->fillers, g_list_free);
+  g_list_free_full(g_steal_pointer(&priv->pool),
+      (GDestroyNotify)flow_grid_pool_free);
   GTK_WIDGET_CLASS(flow_grid_parent_class)->destroy(self);
 }
 
@@ -257,6 +280,11 @@ static void flow_grid_init ( FlowGrid *self )
 
   priv->grid = GTK_GRID(gtk_grid_new());
   gtk_container_add(GTK_CONTAINER(self), GTK_WIDGET(priv->grid));
+  priv->children = g_sequence_new(NULL);
+  priv->slots = g_hash_table_new_full(g_direct_hash, g_direct_equal, NULL,
+      g_free);
+  priv->dirty = g_hash_table_new(g_direct_hash, g_direct_equal);
+  priv->dim = -1;
 
   sig = g_strdup_printf("flow-item-%p", (void *)self);
   priv->dnd_target = gtk_target_entry_new(sig, 0, SFWB_DND_TARGET_FLOW_ITEM);
@@ -285,46 +313,60 @@ GtkTargetEntry *flow_grid_get_dnd_target ( GtkWidget *self )
   return priv->dnd_target;
 }
 
-static void flow_grid_remove_widget_maybe (GtkWidget *widget, GtkWidget *self)
+void flow_grid_invalidate ( GtkWidget *self )
 {
   FlowGridPrivate *priv;
+  GList *iter;
 
   g_return_if_fail(IS_FLOW_GRID(self));
   priv = flow_grid_get_instance_private(FLOW_GRID(self));
 
-  if(!g_list_find(priv->children, widget))
-    gtk_container_remove (GTK_CONTAINER(priv->grid), widget);
+  for(iter=base_widget_get_mirror_children(self); iter; iter=g_list_next(iter))
+    flow_grid_invalidate(iter->data);
+
+  priv->invalid = TRUE;
+  priv->resort = TRUE;
 }
 
-void flow_grid_invalidate ( GtkWidget *self )
+/* queue a single child to be updated and repositioned on the next update,
+ * without re-sorting and re-attaching the rest of the grid */
+void flow_grid_invalidate_child ( GtkWidget *self, GtkWidget *child )
 {
   FlowGridPrivate *priv;
-  GList *iter;
 
   g_return_if_fail(IS_FLOW_GRID(self));
   priv = flow_grid_get_instance_private(FLOW_GRID(self));
 
-  for(iter=base_widget_get_mirror_children(self); iter; iter=g_list_next(iter))
-    flow_grid_invalidate(iter->data);
+  if(!priv->slots || !g_hash_table_contains(priv->slots, child))
+    return;
 
+  g_hash_table_add(priv->dirty, child);
   priv->invalid = TRUE;
 }
 
 void flow_grid_add_child ( GtkWidget *self, GtkWidget *child )
 {
   FlowGridPrivate *priv;
+  flow_grid_slot_t *slot;
 
   g_return_if_fail(IS_FLOW_GRID(self));
   priv = flow_grid_get_instance_private(FLOW_GRID(self));
 
-  priv->children = g_list_append(priv->children, child);
+  if(g_hash_table_contains(priv->slots, child))
+    return;
+
+  slot = g_malloc0(sizeof(flow_grid_slot_t));
+  slot->iter = g_sequence_append(priv->children, child);
+  slot->pos = -1;
+  g_hash_table_insert(priv->slots, child, slot);
   flow_item_set_parent(child, self);
-  flow_grid_invalidate(self);
+  flow_grid_invalidate_child(self, child);
 }
 
 void flow_grid_delete_child ( GtkWidget *self, void *source )
 {
   FlowGridPrivate *priv;
+  flow_grid_slot_t *slot;
   GtkWidget *child;
 
   g_return_if_fail(IS_FLOW_GRID(self));
@@ -333,9 +375,49 @@ void flow_grid_delete_child ( GtkWidget *self, void *source )
   if( !(child = flow_grid_find_child(self, source)) )
     return;
 
-  priv->children = g_list_remove(priv->children, child);
-  g_object_unref(child);
-  flow_grid_invalidate(self);
+  if( (slot = g_hash_table_lookup(priv->slots, child)) )
+    g_sequence_remove(slot->iter);
+  g_hash_table_remove(priv->dirty, child);
+  g_hash_table_remove(priv->slots, child);
+  if(gtk_widget_get_parent(child) == GTK_WIDGET(priv->grid))
+    gtk_container_remove(GTK_CONTAINER(priv->grid), child);
+
+  /* keep a few detached children around to re-bind to new sources */
+  if(flow_item_can_recycle(child) &&
+      g_list_length(priv->pool) < FLOW_GRID_POOL_SIZE)
+  {
+    flow_item_set_source(child, NULL);
+    priv->pool = g_list_prepend(priv->pool, child);
+  }
+  else
+    g_object_unref(child);
+  priv->invalid = TRUE;
+}
+
+/* the pool may hold children of several classes (i.e. items and popups in
+ * a taskbar shell), only re-bind a child of the requested type */
+GtkWidget *flow_grid_recycle_child ( GtkWidget *self, GType type,
+    void *source )
+{
+  FlowGridPrivate *priv;
+  GtkWidget *child;
+  GList *iter;
+
+  g_return_val_if_fail(IS_FLOW_GRID(self), NULL);
+  priv = flow_grid_get_instance_private(FLOW_GRID(self));
+
+  for(iter=priv->pool; iter; iter=g_list_next(iter))
+    if(G_OBJECT_TYPE(iter->data) == type)
+      break;
+  if(!iter)
+    return NULL;
+
+  child = iter->data;
+  priv->pool = g_list_delete_link(priv->pool, iter);
+  flow_item_set_source(child, source);
+  flow_grid_add_child(self, child);
+
+  return child;
 }
 
 static void flow_grid_child_position ( GtkGrid *grid, GtkWidget *child,
@@ -352,34 +434,99 @@ static void flow_grid_child_position ( GtkGrid *grid, GtkWidget *child,
         NULL);
 }
 
+static gboolean flow_grid_child_sorted ( GtkWidget *self,
+    GSequenceIter *iter )
+{
+  GSequenceIter *next;
+
+  if(!g_sequence_iter_is_begin(iter) && flow_item_compare(
+        g_sequence_get(g_sequence_iter_prev(iter)), g_sequence_get(iter),
+        self) > 0)
+    return FALSE;
+
+  next = g_sequence_iter_next(iter);
+  return g_sequence_iter_is_end(next) || flow_item_compare(
+      g_sequence_get(iter), g_sequence_get(next), self) <= 0;
+}
+
+static void flow_grid_fillers_reset ( GtkWidget *self, gint i )
+{
+  FlowGridPrivate *priv;
+  GtkWidget *filler;
+
+  priv = flow_grid_get_instance_private(FLOW_GRID(self));
+
+  g_list_free_full(g_steal_pointer(&priv->fillers),
+      (GDestroyNotify)gtk_widget_destroy);
+  for(; i<priv->dim; i++)
+  {
+    filler = gtk_label_new("");
+    priv->fillers = g_list_prepend(priv->fillers, filler);
+    gtk_grid_attach(priv->grid, filler,
+        priv->axis_cols? 0 : i, priv->axis_cols? i : 0, 1, 1);
+  }
+}
+
 gboolean flow_grid_update ( GtkWidget *self )
 {
   FlowGridPrivate *priv;
-  GList *iter;
+  flow_grid_slot_t *slot;
+  GSequenceIter *iter;
+  GList *dirty, *liter;
+  GtkWidget *child;
+  gboolean relayout;
   gint count, i, dim, axis_cols;
 
   g_return_val_if_fail(IS_FLOW_GRID(self), FALSE);
   priv = flow_grid_get_instance_private(FLOW_GRID(self));
 
-  if(!priv->invalid)
+  if(!priv->invalid || !priv->children)
     return TRUE;
   priv->invalid = FALSE;
 
-  gtk_container_foreach(GTK_CONTAINER(priv->grid),
-      (GtkCallback)flow_grid_remove_widget_maybe, self);
+  dirty = g_hash_table_get_keys(priv->dirty);
+  g_hash_table_remove_all(priv->dirty);
 
-  if(priv->sort)
-    priv->children = g_list_sort_with_data(priv->children,
-        (GCompareDataFunc)flow_item_compare, self);
-
-  count = 0;
-  for(iter=priv->children; iter; iter=g_list_next(iter))
+  if(priv->resort)
   {
-    flow_item_update(iter->data);
-    if(flow_item_get_active(iter->data))
-      count++;
+    g_sequence_foreach(priv->children, (GFunc)flow_item_update, NULL);
+    if(priv->sort)
+      g_sequence_sort(priv->children, (GCompareDataFunc)flow_item_compare,
+          self);
+  }
+  else
+  {
+    for(liter=dirty; liter; liter=g_list_next(liter))
+      if( (slot = g_hash_table_lookup(priv->slots, liter->data)) )
+      {
+        flow_item_update(liter->data);
+        slot->touched = TRUE;
+      }
+
+    /* a single child can be moved in place, otherwise take all updated
+     * children out before re-inserting any of them, so the binary search
+     * only sees children that are still in order */
+    if(priv->sort && dirty && !dirty->next)
+    {
+      if( (slot = g_hash_table_lookup(priv->slots, dirty->data)) &&
+          !flow_grid_child_sorted(self, slot->iter))
+        g_sequence_sort_changed(slot->iter,
+            (GCompareDataFunc)flow_item_compare, self);
+    }
+    else if(priv->sort)
+    {
+      for(liter=dirty; liter; liter=g_list_next(liter))
+        if( (slot = g_hash_table_lookup(priv->slots, liter->data)) )
+          g_sequence_remove(slot->iter);
+      for(liter=dirty; liter; liter=g_list_next(liter))
+        if( (slot = g_hash_table_lookup(priv->slots, liter->data)) )
+          slot->iter = g_sequence_insert_sorted(priv->children, liter->data,
+              (GCompareDataFunc)flow_item_compare, self);
+    }
   }
+  g_list_free(dirty);
 
+  count = flow_grid_n_children(self);
   axis_cols = (priv->primary_axis == FLOW_GRID_AXIS_COLS ||
      (priv->primary_axis == FLOW_GRID_AXIS_DEFAULT && priv->rows>0));
 
@@ -388,21 +535,47 @@ gboolean flow_grid_update ( GtkWidget *self )
   else
     dim = priv->cols>0? priv->cols : (count/priv->rows) + !!(count%priv->rows);
 
+  relayout = priv->resort || dim!=priv->dim || axis_cols!=priv->axis_cols;
+
   i = 0;
-  for(iter=priv->children; iter; iter=g_list_next(iter))
-    if(flow_item_get_active(iter->data))
+  for(iter=g_sequence_get_begin_iter(priv->children);
+      !g_sequence_iter_is_end(iter); iter=g_sequence_iter_next(iter))
+  {
+    child = g_sequence_get(iter);
+    slot = g_hash_table_lookup(priv->slots, child);
+    if(flow_item_get_active(child))
     {
-      flow_grid_child_position(priv->grid, iter->data,
-          axis_cols? i/dim : i%dim, axis_cols? i%dim : i/dim);
+      if(relayout || slot->pos != i)
+      {
+        flow_grid_child_position(priv->grid, child,
+            axis_cols? i/dim : i%dim, axis_cols? i%dim : i/dim);
+        slot->pos = i;
+        slot->touched = TRUE;
+      }
+      if(slot->touched && !priv->resort)
+        css_widget_cascade(child, NULL);
       i++;
     }
-    else if(gtk_widget_get_parent(iter->data) == GTK_WIDGET(priv->grid))
-      gtk_container_remove(GTK_CONTAINER(priv->grid), iter->data);
+    else
+    {
+      if(gtk_widget_get_parent(child) == GTK_WIDGET(priv->grid))
+        gtk_container_remove(GTK_CONTAINER(priv->grid), child);
+      slot->pos = -1;
+    }
+    slot->touched = FALSE;
+  }
 
-  for(;i<dim; i++)
-    gtk_grid_attach(priv->grid, gtk_label_new(""),
-        axis_cols? 0 : i, axis_cols? i : 0, 1, 1);
-  css_widget_cascade(self, NULL);
+  if(relayout || count != priv->count)
+  {
+    priv->dim = dim;
+    priv->axis_cols = axis_cols;
+    flow_grid_fillers_reset(self, i);
+  }
+  priv->count = count;
+
+  if(priv->resort)
+    css_widget_cascade(self, NULL);
+  priv->resort = FALSE;
 
   return TRUE;
 }
@@ -410,14 +583,15 @@ gboolean flow_grid_update ( GtkWidget *self )
 guint flow_grid_n_children ( GtkWidget *self )
 {
   FlowGridPrivate *priv;
-  GList *iter;
+  GSequenceIter *iter;
   guint n = 0;
 
   g_return_val_if_fail(IS_FLOW_GRID(self),0);
   priv = flow_grid_get_instance_private(FLOW_GRID(self));
 
-  for(iter=priv->children; iter; iter=g_list_next(iter))
-    if(flow_item_get_active(iter->data))
+  for(iter=g_sequence_get_begin_iter(priv->children);
+      !g_sequence_iter_is_end(iter); iter=g_sequence_iter_next(iter))
+    if(flow_item_get_active(g_sequence_get(iter)))
       n++;
 
   return n;
@@ -426,32 +600,35 @@ guint flow_grid_n_children ( GtkWidget *self )
 gpointer flow_grid_find_child ( GtkWidget *self, gconstpointer source )
 {
   FlowGridPrivate *priv;
-  GList *iter;
+  GSequenceIter *iter;
 
   g_return_val_if_fail(IS_FLOW_GRID(self), NULL);
   priv = flow_grid_get_instance_private(FLOW_GRID(self));
 
-  iter = g_list_find_custom(priv->children, source,
-      (GCompareFunc)flow_item_check_source);
-  return iter? iter->data : NULL;
+  for(iter=g_sequence_get_begin_iter(priv->children);
+      !g_sequence_iter_is_end(iter); iter=g_sequence_iter_next(iter))
+    if(!flow_item_check_source(g_sequence_get(iter), source))
+      return g_sequence_get(iter);
+
+  return NULL;
 }
 
 void flow_grid_children_order ( GtkWidget *self, GtkWidget *ref,
     GtkWidget *child, gboolean after )
 {
   FlowGridPrivate *priv;
-  GList *dlist;
+  flow_grid_slot_t *rslot, *cslot;
 
   g_return_if_fail(IS_FLOW_GRID(self));
   priv = flow_grid_get_instance_private(FLOW_GRID(self));
 
-  dlist = g_list_find(priv->children, ref);
-  if(!dlist || !g_list_find(priv->children, child))
+  rslot = g_hash_table_lookup(priv->slots, ref);
+  cslot = g_hash_table_lookup(priv->slots, child);
+  if(!rslot || !cslot)
     return;
 
-  priv->children = g_list_remove(priv->children, child);
-  priv->children = g_list_insert_before(priv->children,
-      after ? g_list_next(dlist) : dlist, child);
+  g_sequence_move(cslot->iter,
+      after ? g_sequence_iter_next(rslot->iter) : rslot->iter);
 
   flow_item_invalidate(child);
   flow_item_invalidate(ref);
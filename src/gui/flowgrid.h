@@ -46,9 +46,14 @@ struct _FlowGridPrivate
   gint primary_axis;
   gboolean icons, labels, tooltips;
   gint title_width;
-  gboolean invalid;
+  gboolean invalid, resort;
   gboolean sort;
-  GList *children;
+  GSequence *children;
+  GHashTable *slots;
+  GHashTable *dirty;
+  GList *fillers;
+  GList *pool;
+  gint dim, count, axis_cols;
   gint (*comp)( GtkWidget *, GtkWidget *, GtkWidget * );
   GtkTargetEntry *dnd_target;
   GtkWidget *parent;
@@ -60,7 +65,10 @@ GType flow_grid_get_type ( void );
 void flow_grid_add_child ( GtkWidget *self, GtkWidget *child );
 gboolean flow_grid_update ( GtkWidget *self );
 void flow_grid_invalidate ( GtkWidget *self );
+void flow_grid_invalidate_child ( GtkWidget *self, GtkWidget *child );
 void flow_grid_delete_child ( GtkWidget *, void *parent );
+GtkWidget *flow_grid_recycle_child ( GtkWidget *self, GType type,
+    void *source );
 guint flow_grid_n_children ( GtkWidget *self );
 gpointer flow_grid_find_child ( GtkWidget *, gconstpointer parent );
 void flow_grid_child_dnd_enable ( GtkWidget *, GtkWidget *, GtkWidget *);
@@ -69,6 +69,8 @@ void flow_item_set_parent ( GtkWidget *self, GtkWidget *parent )
   g_return_if_fail(IS_FLOW_ITEM(self));
   priv = flow_item_get_instance_private(FLOW_ITEM(self));
 
+  if(priv->parent == parent)
+    return;
   if(priv->parent)  
     g_signal_handlers_disconnect_by_data(G_OBJECT(priv->parent), self);
   priv->parent = parent;
@@ -141,6 +143,21 @@ void *flow_item_get_source ( GtkWidget *self )
     return NULL;
 }
 
+void flow_item_set_source ( GtkWidget *self, void *source )
+{
+  g_return_if_fail(IS_FLOW_ITEM(self));
+
+  if(FLOW_ITEM_GET_CLASS(self)->set_source)
+    FLOW_ITEM_GET_CLASS(self)->set_source(self, source);
+}
+
+gboolean flow_item_can_recycle ( GtkWidget *self )
+{
+  g_return_val_if_fail(IS_FLOW_ITEM(self), FALSE);
+
+  return !!FLOW_ITEM_GET_CLASS(self)->set_source;
+}
+
 gint flow_item_check_source ( GtkWidget *self, gconstpointer source )
 {
   g_return_val_if_fail(IS_FLOW_ITEM(self), 1);
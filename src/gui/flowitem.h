@@ -26,6 +26,7 @@ struct _FlowItemClass
   void (*update) ( GtkWidget *self );
   void (*invalidate) ( GtkWidget *self );
   void* (*get_source) ( GtkWidget *self );
+  void (*set_source) ( GtkWidget *self, void *source );
   gint (*compare) (GtkWidget *, GtkWidget *, GtkWidget *);
   void (*dnd_dest) ( GtkWidget *self, GtkWidget *src, gint x, gint y );
   GCompareFunc comp_source;
@@ -44,6 +45,8 @@ GType flow_item_get_type ( void );
 void flow_item_update ( GtkWidget *self );
 void flow_item_invalidate ( GtkWidget *self );
 void *flow_item_get_source ( GtkWidget *self );
+void flow_item_set_source ( GtkWidget *self, void *source );
+gboolean flow_item_can_recycle ( GtkWidget *self );
 void flow_item_set_parent ( GtkWidget *self, GtkWidget *parent );
 void flow_item_set_active ( GtkWidget *self, gboolean );
 GtkWidget *flow_item_get_parent ( GtkWidget *self );
@@ -8,6 +8,149 @@
 
 G_DEFINE_TYPE_WITH_CODE (Label, label, BASE_WIDGET_TYPE, G_ADD_PRIVATE (Label))
 
+enum {
+  LABEL_WIDTH_CHARS = 1,
+};
+
+/* width reserved by width_chars, computed the same way GtkLabel does */
+static gint label_reserved_width ( PangoLayout *layout, gint chars )
+{
+  PangoContext *context;
+  PangoFontMetrics *metrics;
+  gint width;
+
+  context = pango_layout_get_context(layout);
+  metrics = pango_context_get_metrics(context,
+      pango_context_get_font_description(context),
+      pango_context_get_language(context));
+  width = MAX(pango_font_metrics_get_approximate_char_width(metrics),
+      pango_font_metrics_get_approximate_digit_width(metrics));
+  pango_font_metrics_unref(metrics);
+
+  return PANGO_PIXELS(width * chars);
+}
+
+static void label_text_size ( PangoLayout *layout, gint *width,
+    gint *height )
+{
+  PangoLayout *copy;
+
+  copy = pango_layout_copy(layout);
+  pango_layout_set_width(copy, -1);
+  pango_layout_get_pixel_size(copy, width, height);
+  g_object_unref(copy);
+}
+
+/* GtkLabel queues a resize on every text change, relayouting the whole
+ * bar. If plain text on a single line is replaced with text of the same
+ * size (or both fit into the reserved width), keep the GtkLabel as it is
+ * and draw the new text over it from a copy of its layout instead. The
+ * GtkLabel still holds the text its size was computed for */
+static gboolean label_update_in_place ( GtkWidget *self, const gchar *value )
+{
+  LabelPrivate *priv;
+  PangoLayout *current, *layout;
+  gint ow, oh, nw, nh;
+
+  priv = label_get_instance_private(LABEL(self));
+
+  if(!value || priv->markup || !gtk_widget_get_mapped(priv->label) ||
+      strchr(value, '\n'))
+    return FALSE;
+
+  current = gtk_label_get_layout(GTK_LABEL(priv->label));
+  if(pango_layout_is_ellipsized(current) ||
+      pango_layout_get_line_count(current) != 1)
+    return FALSE;
+
+  if(!g_strcmp0(value, gtk_label_get_text(GTK_LABEL(priv->label))))
+  {
+    g_clear_object(&priv->layout);
+    gtk_widget_queue_draw(priv->label);
+    return TRUE;
+  }
+
+  layout = pango_layout_copy(current);
+  pango_layout_set_text(layout, value, -1);
+  label_text_size(current, &ow, &oh);
+  label_text_size(layout, &nw, &nh);
+  if(oh != nh || (ow != nw && (priv->width_chars <= 0 ||
+        MAX(ow, nw) > label_reserved_width(current, priv->width_chars))))
+  {
+    g_object_unref(layout);
+    return FALSE;
+  }
+
+  g_clear_object(&priv->layout);
+  priv->layout = layout;
+  gtk_widget_queue_draw(priv->label);
+
+  return TRUE;
+}
+
+/* render the in place text the way GtkLabel would render its own */
+static gboolean label_draw ( GtkWidget *label, cairo_t *cr, GtkWidget *self )
+{
+  LabelPrivate *priv;
+  GtkStyleContext *style;
+  GtkStateFlags flags;
+  GtkBorder border, padding, margin;
+  PangoRectangle logical;
+  gfloat xalign, yalign;
+  gint width, height, x, y;
+
+  g_return_val_if_fail(IS_LABEL(self), FALSE);
+  priv = label_get_instance_private(LABEL(self));
+
+  if(!priv->layout)
+    return FALSE;
+
+  style = gtk_widget_get_style_context(label);
+  flags = gtk_style_context_get_state(style);
+  gtk_style_context_get_border(style, flags, &border);
+  gtk_style_context_get_padding(style, flags, &padding);
+  gtk_style_context_get_margin(style, flags, &margin);
+
+  width = gtk_widget_get_allocated_width(label) - margin.left - margin.right;
+  height = gtk_widget_get_allocated_height(label) - margin.top -
+    margin.bottom;
+  gtk_render_background(style, cr, margin.left, margin.top, width, height);
+  gtk_render_frame(style, cr, margin.left, margin.top, width, height);
+
+  width -= border.left + border.right + padding.left + padding.right;
+  height -= border.top + border.bottom + padding.top + padding.bottom;
+  xalign = gtk_label_get_xalign(GTK_LABEL(label));
+  if(gtk_widget_get_direction(label) == GTK_TEXT_DIR_RTL)
+    xalign = 1.0 - xalign;
+  yalign = gtk_label_get_yalign(GTK_LABEL(label));
+
+  pango_layout_get_pixel_extents(priv->layout, NULL, &logical);
+  x = margin.left + border.left + padding.left +
+    xalign * (width - logical.width) - logical.x;
+  y = margin.top + border.top + padding.top +
+    yalign * (height - logical.height) - logical.y;
+  gtk_render_layout(style, cr, x, y, priv->layout);
+
+  return TRUE;
+}
+
+/* a style change may change the font, hand the text back to GtkLabel */
+static void label_style_updated ( GtkWidget *label, GtkWidget *self )
+{
+  LabelPrivate *priv;
+  gchar *text;
+
+  g_return_if_fail(IS_LABEL(self));
+  priv = label_get_instance_private(LABEL(self));
+
+  if(!priv->layout)
+    return;
+  text = g_strdup(pango_layout_get_text(priv->layout));
+  g_clear_object(&priv->layout);
+  gtk_label_set_text(GTK_LABEL(priv->label), text);
+  g_free(text);
+}
+
 static void label_update_value ( GtkWidget *self )
 {
   LabelPrivate *priv;
@@ -17,15 +160,95 @@ static void label_update_value ( GtkWidget *self )
   priv = label_get_instance_private(LABEL(self));
 
   value = base_widget_get_value(self);
-  if(value && pango_parse_markup(value, -1, 0, NULL, NULL, NULL, NULL))
+  if(!value || !pango_parse_markup(value, -1, 0, NULL, NULL, NULL, NULL) ||
+      !strpbrk(value, "<&"))
+  {
+    if(label_update_in_place(self, value))
+      return;
+    priv->markup = FALSE;
+  }
+  else
+    priv->markup = TRUE;
+
+  /* the GtkLabel may still hold this text while a different one was
+   * drawn in place, so it won't redraw by itself */
+  if(priv->layout)
+  {
+    g_clear_object(&priv->layout);
+    gtk_widget_queue_draw(priv->label);
+  }
+  if(priv->markup)
     gtk_label_set_markup(GTK_LABEL(priv->label), value);
   else
     gtk_label_set_text(GTK_LABEL(priv->label), value);
 }
 
+static void label_mirror ( GtkWidget *self, GtkWidget *src )
+{
+  g_return_if_fail(IS_LABEL(self));
+  g_return_if_fail(IS_LABEL(src));
+
+  BASE_WIDGET_CLASS(label_parent_class)->mirror(self, src);
+  g_object_bind_property(G_OBJECT(src), "width_chars", G_OBJECT(self),
+      "width_chars", G_BINDING_SYNC_CREATE);
+}
+
+static void label_destroy ( GtkWidget *self )
+{
+  LabelPrivate *priv;
+
+  g_return_if_fail(IS_LABEL(self));
+  priv = label_get_instance_private(LABEL(self));
+
+  g_clear_object(&priv->layout);
+  GTK_WIDGET_CLASS(label_parent_class)->destroy(self);
+}
+
+static void label_get_property ( GObject *self, guint id, GValue *value,
+    GParamSpec *spec )
+{
+  LabelPrivate *priv;
+
+  priv = label_get_instance_private(LABEL(self));
+  switch(id)
+  {
+    case LABEL_WIDTH_CHARS:
+      g_value_set_int(value, priv->width_chars);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID(self, id, spec);
+  }
+}
+
+static void label_set_property ( GObject *self, guint id,
+    const GValue *value, GParamSpec *spec )
+{
+  LabelPrivate *priv;
+
+  priv = label_get_instance_private(LABEL(self));
+  switch(id)
+  {
+    case LABEL_WIDTH_CHARS:
+      priv->width_chars = g_value_get_int(value);
+      gtk_label_set_width_chars(GTK_LABEL(priv->label),
+          priv->width_chars>0? priv->width_chars : -1);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID(self, id, spec);
+  }
+}
+
 static void label_class_init ( LabelClass *kclass )
 {
   BASE_WIDGET_CLASS(kclass)->update_value = label_update_value;
+  BASE_WIDGET_CLASS(kclass)->mirror = label_mirror;
+  GTK_WIDGET_CLASS(kclass)->destroy = label_destroy;
+  G_OBJECT_CLASS(kclass)->get_property = label_get_property;
+  G_OBJECT_CLASS(kclass)->set_property = label_set_property;
+
+  g_object_class_install_property(G_OBJECT_CLASS(kclass), LABEL_WIDTH_CHARS,
+      g_param_spec_int("width_chars", "width_chars", "sfwbar_config", -1,
+        G_MAXINT, -1, G_PARAM_READWRITE));
 }
 
 static void label_init ( Label *self )
@@ -34,9 +257,14 @@ static void label_init ( Label *self )
 
   priv = label_get_instance_private(LABEL(self));
 
+  priv->width_chars = -1;
   priv->label = gtk_label_new("");
   gtk_label_set_ellipsize(GTK_LABEL(priv->label), PANGO_ELLIPSIZE_END);
   gtk_label_set_line_wrap(GTK_LABEL(priv->label), TRUE);
   gtk_label_set_line_wrap_mode(GTK_LABEL(priv->label), PANGO_WRAP_WORD_CHAR);
   gtk_container_add(GTK_CONTAINER(self), priv->label);
+  g_signal_connect(G_OBJECT(priv->label), "draw",
+      G_CALLBACK(label_draw), self);
+  g_signal_connect(G_OBJECT(priv->label), "style-updated",
+      G_CALLBACK(label_style_updated), self);
 }
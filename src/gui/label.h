@@ -27,6 +27,9 @@ typedef struct _LabelPrivate LabelPrivate;
 struct _LabelPrivate
 {
   GtkWidget *label;
+  PangoLayout *layout;
+  gint width_chars;
+  gboolean markup;
 };
 
 GType label_get_type ( void );
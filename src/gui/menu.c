@@ -8,6 +8,7 @@
 #include "taskbarpopup.h"
 #include "scaleimage.h"
 #include "popup.h"
+#include "config/config.h"
 #include "gui/menuitem.h"
 #include "util/string.h"
 #include "vm/vm.h"
@@ -106,6 +107,7 @@ static void menu_item_set_name ( GtkWidget *item, void *d )
 
 static void menu_set_names ( GtkWidget *menu )
 {
+  config_deferred_build(menu);
   gtk_container_foreach(GTK_CONTAINER(menu), menu_item_set_name, NULL);
 }
 
@@ -171,8 +171,8 @@ void menu_item_set_label_expr ( GtkWidget *self, GBytes *code )
 
   if(priv->label_expr)
   {
-    priv->label_expr->code = code;
-    priv->label_expr->eval = TRUE;
+    expr_cache_set_code(priv->label_expr, code);
+    g_bytes_unref(code);
   }
   else
     priv->label_expr = expr_cache_new_with_code(code);
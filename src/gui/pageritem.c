@@ -94,7 +94,7 @@ static void pager_item_invalidate ( GtkWidget *self )
   g_return_if_fail(IS_PAGER_ITEM(self));
   priv = pager_item_get_instance_private(PAGER_ITEM(self));
 
-  flow_grid_invalidate(priv->pager);
+  flow_grid_invalidate_child(priv->pager, self);
   priv->invalid = TRUE;
 }
 
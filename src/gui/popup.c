@@ -9,6 +9,7 @@
 #include "basewidget.h"
 #include "popup.h"
 #include "bar.h"
+#include "config/config.h"
 #include "util/string.h"
 #include <gtk-layer-shell.h>
 
@@ -144,6 +145,7 @@ void popup_show ( GtkWidget *parent, GtkWidget *popup, GdkSeat *seat )
   child = gtk_bin_get_child(GTK_BIN(popup));
   if(!child)
     return;
+  config_deferred_build(child);
 
   g_hash_table_iter_init(&iter, popup_list);
   while(g_hash_table_iter_next(&iter, NULL, (gpointer *)&old_popup))
@@ -14,6 +14,24 @@ G_DEFINE_TYPE_WITH_CODE (ScaleImage, scale_image, GTK_TYPE_IMAGE,
     G_ADD_PRIVATE (ScaleImage))
 
 static GHashTable *scaleimage_cache;
+static GHashTable *scaleimage_surfaces;
+
+typedef struct _scale_image_surface {
+  cairo_surface_t *cs;
+  gboolean fallback;
+} scale_image_surface_t;
+
+static void scale_image_surface_free ( scale_image_surface_t *surface )
+{
+  cairo_surface_destroy(surface->cs);
+  g_free(surface);
+}
+
+static void scale_image_surfaces_flush ( void )
+{
+  if(scaleimage_surfaces)
+    g_hash_table_remove_all(scaleimage_surfaces);
+}
 
 gboolean scale_image_cache_insert ( gchar *name, GdkPixbuf *pb )
 {
@@ -149,18 +167,87 @@ static void scale_image_blur_render ( GtkWidget *self )
   }
 }
 
+/* mirrored widgets on outputs with the same scale render the same image at
+ * the same size, so rendered surfaces are shared between them */
+static gchar *scale_image_surface_key ( GtkWidget *self, gint w, gint h )
+{
+  ScaleImagePrivate *priv;
+  GdkRGBA col;
+  gchar *key, *color;
+
+  priv = scale_image_get_instance_private(SCALE_IMAGE(self));
+
+  if(priv->ftype == SI_ICON || priv->ftype == SI_FILE)
+    return g_strdup_printf("%d:%dx%d@%d:%s", priv->ftype, w, h,
+        gtk_widget_get_scale_factor(self), priv->fname);
+  if(priv->ftype == SI_BUFF)
+    return g_strdup_printf("%d:%dx%d@%d:%s", priv->ftype, w, h,
+        gtk_widget_get_scale_factor(self), priv->file);
+  if(priv->ftype != SI_DATA)
+    return NULL;
+
+  if(strstr(priv->file, "@theme_fg_color"))
+  {
+    gtk_style_context_get_color(gtk_widget_get_style_context(self),
+        GTK_STATE_FLAG_NORMAL, &col);
+    color = gdk_rgba_to_string(&col);
+  }
+  else
+    color = NULL;
+  key = g_strdup_printf("%d:%dx%d@%d:%s:%s", priv->ftype, w, h,
+      gtk_widget_get_scale_factor(self), color?color:"", priv->file);
+  g_free(color);
+
+  return key;
+}
+
+static void scale_image_surface_release ( GtkWidget *self )
+{
+  ScaleImagePrivate *priv;
+  scale_image_surface_t *surface;
+
+  priv = scale_image_get_instance_private(SCALE_IMAGE(self));
+
+  if(priv->skey && scaleimage_surfaces &&
+      (surface = g_hash_table_lookup(scaleimage_surfaces, priv->skey)) &&
+      surface->cs == priv->cs &&
+      cairo_surface_get_reference_count(priv->cs) <= 2)
+    g_hash_table_remove(scaleimage_surfaces, priv->skey);
+
+  g_clear_pointer(&priv->cs, cairo_surface_destroy);
+  g_clear_pointer(&priv->skey, g_free);
+}
+
 static void scale_image_surface_update ( GtkWidget *self, gint w, gint h )
 {
   ScaleImagePrivate *priv;
+  scale_image_surface_t *surface;
   GdkPixbuf *buf, *tmp;
   GdkPixbufLoader *loader;
   GdkRGBA col;
-  gchar *fallback, *svg, *rgba, alpha[8];
+  cairo_surface_t *cs;
+  gchar *fallback, *svg, *rgba, alpha[8], *key;
   gboolean aspect;
 
   priv = scale_image_get_instance_private(SCALE_IMAGE(self));
   priv->fallback = FALSE;
 
+  key = scale_image_surface_key(self, w, h);
+  if(key && scaleimage_surfaces &&
+      (surface = g_hash_table_lookup(scaleimage_surfaces, key)) )
+  {
+    cs = cairo_surface_reference(surface->cs);
+    priv->fallback = surface->fallback;
+    scale_image_surface_release(self);
+    g_clear_pointer(&priv->shadow, cairo_surface_destroy);
+    priv->cs = cs;
+    priv->skey = key;
+    priv->width = w;
+    priv->height = h;
+    scale_image_blur_render(self);
+    return;
+  }
+
   if(priv->ftype == SI_ICON)
     buf =  gtk_icon_theme_load_icon(priv->theme, priv->fname, MIN(w, h), 0,
         NULL);
@@ -229,15 +316,29 @@ static void scale_image_surface_update ( GtkWidget *self, gint w, gint h )
     g_object_unref(G_OBJECT(tmp));
   }
 
-  g_clear_pointer(&priv->cs, cairo_surface_destroy); 
+  scale_image_surface_release(self);
   g_clear_pointer(&priv->shadow, cairo_surface_destroy); 
   if(!buf)
+  {
+    g_free(key);
     return;
+  }
 
   priv->width = w;
   priv->height = h;
   priv->cs = gdk_cairo_surface_create_from_pixbuf(buf, 0,
       gtk_widget_get_window(self));
+  if(key)
+  {
+    if(!scaleimage_surfaces)
+      scaleimage_surfaces = g_hash_table_new_full(g_str_hash, g_str_equal,
+          g_free, (GDestroyNotify)scale_image_surface_free);
+    surface = g_malloc0(sizeof(scale_image_surface_t));
+    surface->cs = cairo_surface_reference(priv->cs);
+    surface->fallback = priv->fallback;
+    g_hash_table_insert(scaleimage_surfaces, g_strdup(key), surface);
+    priv->skey = key;
+  }
   scale_image_blur_render(self);
   g_object_unref(G_OBJECT(buf));
 }
@@ -351,7 +452,7 @@ static void scale_image_clear ( GtkWidget *self )
   g_clear_pointer(&priv->file, g_free);
   g_clear_pointer(&priv->extra, g_free);
   g_clear_pointer(&priv->pixbuf, g_object_unref);
-  g_clear_pointer(&priv->cs, cairo_surface_destroy);
+  scale_image_surface_release(self);
   g_clear_pointer(&priv->shadow, cairo_surface_destroy);
   g_clear_pointer(&priv->shadow_color, gdk_rgba_free);
   priv->ftype = SI_NONE;
@@ -412,6 +513,9 @@ static void scale_image_class_init ( ScaleImageClass *kclass )
   widget_class->get_preferred_height = scale_image_get_preferred_height;
   widget_class->style_updated = scale_image_style_updated;
 
+  g_signal_connect(G_OBJECT(gtk_icon_theme_get_default()), "changed",
+      G_CALLBACK(scale_image_surfaces_flush), NULL);
+
   gtk_widget_class_install_style_property( widget_class,
       g_param_spec_boxed("color", "image color",
         "draw image in this color using it's alpha channel as a mask",
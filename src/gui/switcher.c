@@ -61,7 +61,8 @@ static gboolean switcher_update ( GtkWidget *self )
 
 static void switcher_init_item (window_t *win, GtkWidget *self )
 {
-  flow_grid_add_child(self, switcher_item_new(win, self));
+  if(!flow_grid_recycle_child(self, SWITCHER_ITEM_TYPE, win))
+    flow_grid_add_child(self, switcher_item_new(win, self));
 }
 
 static void switcher_invalidate_item ( window_t *win, GtkWidget *self )
@@ -69,6 +70,14 @@ static void switcher_invalidate_item ( window_t *win, GtkWidget *self )
   flow_item_invalidate(flow_grid_find_child(self, win));
 }
 
+static void switcher_regroup_item ( window_t *win, GtkWidget *self )
+{
+  if(flow_grid_find_child(self, win))
+    switcher_invalidate_item(win, self);
+  else
+    switcher_init_item(win, self);
+}
+
 static void switcher_destroy_item( window_t *win, GtkWidget *self )
 {
   flow_grid_delete_child(self, win);
@@ -78,6 +87,7 @@ static window_listener_t switcher_window_listener = {
   .window_new = (void (*)(window_t *, void *))switcher_init_item,
   .window_invalidate = (void (*)(window_t *, void *))switcher_invalidate_item,
   .window_destroy = (void (*)(window_t *, void *))switcher_destroy_item,
+  .window_regroup = (void (*)(window_t *, void *))switcher_regroup_item,
 };
 
 static void switcher_destroy ( GtkWidget *self )
@@ -100,6 +100,17 @@ window_t *switcher_item_get_window ( GtkWidget *self )
   return priv->win;
 }
 
+static void switcher_item_set_window ( GtkWidget *self, window_t *win )
+{
+  SwitcherItemPrivate *priv;
+
+  g_return_if_fail(IS_SWITCHER_ITEM(self));
+  priv = switcher_item_get_instance_private(SWITCHER_ITEM(self));
+
+  priv->win = win;
+  priv->invalid = TRUE;
+}
+
 static void switcher_item_invalidate ( GtkWidget *self )
 {
   SwitcherItemPrivate *priv;
@@ -107,7 +118,7 @@ static void switcher_item_invalidate ( GtkWidget *self )
   g_return_if_fail(IS_SWITCHER_ITEM(self));
   priv = switcher_item_get_instance_private(SWITCHER_ITEM(self));
 
-  flow_grid_invalidate(priv->switcher);
+  flow_grid_invalidate_child(priv->switcher, self);
   priv->invalid = TRUE;
 }
 
@@ -135,6 +146,8 @@ static void switcher_item_class_init ( SwitcherItemClass *kclass )
   FLOW_ITEM_CLASS(kclass)->invalidate = switcher_item_invalidate;
   FLOW_ITEM_CLASS(kclass)->get_source =
     (void * (*)(GtkWidget *))switcher_item_get_window;
+  FLOW_ITEM_CLASS(kclass)->set_source =
+    (void (*)(GtkWidget *, void *))switcher_item_set_window;
 }
 
 static void switcher_item_init ( SwitcherItem *cgrid )
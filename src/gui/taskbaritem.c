@@ -71,6 +71,17 @@ window_t *taskbar_item_get_window ( GtkWidget *self )
   return priv->win;
 }
 
+static void taskbar_item_set_window ( GtkWidget *self, window_t *win )
+{
+  TaskbarItemPrivate *priv;
+
+  g_return_if_fail(IS_TASKBAR_ITEM(self));
+  priv = taskbar_item_get_instance_private(TASKBAR_ITEM(self));
+
+  priv->win = win;
+  priv->invalid = TRUE;
+}
+
 static gboolean taskbar_item_check ( GtkWidget *self )
 {
   TaskbarItemPrivate *priv;
@@ -198,7 +209,7 @@ static void taskbar_item_invalidate ( GtkWidget *self )
   priv = taskbar_item_get_instance_private(TASKBAR_ITEM(self));
 
   priv->invalid = TRUE;
-  flow_grid_invalidate(priv->taskbar);
+  flow_grid_invalidate_child(priv->taskbar, self);
   if( (holder = taskbar_get_parent(priv->taskbar)) )
       flow_item_invalidate(holder);
 }
@@ -210,6 +221,8 @@ static void taskbar_item_class_init ( TaskbarItemClass *kclass )
   FLOW_ITEM_CLASS(kclass)->invalidate = taskbar_item_invalidate;
   FLOW_ITEM_CLASS(kclass)->get_source =
     (void * (*)(GtkWidget *))taskbar_item_get_window;
+  FLOW_ITEM_CLASS(kclass)->set_source =
+    (void (*)(GtkWidget *, void *))taskbar_item_set_window;
   FLOW_ITEM_CLASS(kclass)->compare = taskbar_item_compare;
 }
 
@@ -228,6 +241,8 @@ GtkWidget *taskbar_item_new( window_t *win, GtkWidget *taskbar )
 
   if(flow_grid_find_child(taskbar, win))
     return NULL;
+  if( (self = flow_grid_recycle_child(taskbar, TASKBAR_ITEM_TYPE, win)) )
+    return self;
 
   self = GTK_WIDGET(g_object_new(taskbar_item_get_type(), NULL));
   priv = taskbar_item_get_instance_private(TASKBAR_ITEM(self));
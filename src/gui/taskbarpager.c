@@ -156,7 +156,7 @@ static void taskbar_pager_invalidate ( GtkWidget *self )
   g_return_if_fail(IS_TASKBAR_PAGER(self));
   priv = taskbar_pager_get_instance_private(TASKBAR_PAGER(self));
 
-  flow_grid_invalidate(priv->shell);
+  flow_grid_invalidate_child(priv->shell, self);
   priv->invalid = TRUE;
 }
 
@@ -123,6 +123,20 @@ static gchar *taskbar_popup_get_appid ( GtkWidget *self )
   return priv->appid;
 }
 
+static void taskbar_popup_set_appid ( GtkWidget *self, const gchar *appid )
+{
+  TaskbarPopupPrivate *priv;
+
+  g_return_if_fail(IS_TASKBAR_POPUP(self));
+  priv = taskbar_popup_get_instance_private(TASKBAR_POPUP(self));
+
+  g_free(priv->appid);
+  priv->appid = g_strdup(appid);
+  priv->invalid = TRUE;
+  if(!appid && priv->popover)
+    gtk_widget_hide(priv->popover);
+}
+
 static void taskbar_popup_decorate ( GtkWidget *parent, GParamSpec *spec,
     GtkWidget *self )
 {
@@ -255,7 +269,7 @@ static void taskbar_popup_invalidate ( GtkWidget *self )
   g_return_if_fail(IS_TASKBAR_POPUP(self));
   priv = taskbar_popup_get_instance_private(TASKBAR_POPUP(self));
 
-  flow_grid_invalidate(priv->shell);
+  flow_grid_invalidate_child(priv->shell, self);
   priv->invalid = TRUE;
 }
 
@@ -269,6 +283,8 @@ static void taskbar_popup_class_init ( TaskbarPopupClass *kclass )
   FLOW_ITEM_CLASS(kclass)->compare = taskbar_popup_compare;
   FLOW_ITEM_CLASS(kclass)->get_source =
     (void * (*)(GtkWidget *))taskbar_popup_get_appid;
+  FLOW_ITEM_CLASS(kclass)->set_source =
+    (void (*)(GtkWidget *, void *))taskbar_popup_set_appid;
 }
 
 static void taskbar_popup_init ( TaskbarPopup *self )
@@ -282,6 +298,10 @@ GtkWidget *taskbar_popup_new( const gchar *appid, GtkWidget *shell )
 
   g_return_val_if_fail(IS_TASKBAR_SHELL(shell), NULL);
 
+  if( (self = flow_grid_recycle_child(shell, TASKBAR_POPUP_TYPE,
+          (gpointer)appid)) )
+    return self;
+
   self = GTK_WIDGET(g_object_new(taskbar_popup_get_type(), NULL));
   priv = taskbar_popup_get_instance_private(TASKBAR_POPUP(self));
 
@@ -60,6 +60,7 @@ static void taskbar_shell_destroy ( GtkWidget *self )
   }
   g_clear_pointer(&priv->css, g_free);
   g_clear_pointer(&priv->style, g_bytes_unref);
+  g_clear_pointer(&priv->items, g_hash_table_destroy);
   GTK_WIDGET_CLASS(taskbar_shell_parent_class)->destroy(self);
 }
 
@@ -94,11 +95,12 @@ static void taskbar_shell_mirror ( GtkWidget *self, GtkWidget *src )
 static void taskbar_shell_item_init ( window_t *win, GtkWidget *self )
 {
   TaskbarShellPrivate *priv;
-  GtkWidget *taskbar;
+  GtkWidget *taskbar, *item;
 
   priv = taskbar_shell_get_instance_private(TASKBAR_SHELL(self));
-  if( (taskbar = priv->get_taskbar(self, win, TRUE)) )
-    taskbar_item_new(win, taskbar);
+  if( (taskbar = priv->get_taskbar(self, win, TRUE)) &&
+      (item = taskbar_item_new(win, taskbar)) )
+    g_hash_table_insert(priv->items, win, item);
 }
 
 static void taskbar_shell_item_invalidate ( window_t *win, GtkWidget *self )
@@ -117,17 +119,36 @@ static void taskbar_shell_item_invalidate ( window_t *win, GtkWidget *self )
 static void taskbar_shell_item_destroy ( window_t *win, GtkWidget *self )
 {
   TaskbarShellPrivate *priv;
-  GtkWidget *taskbar, *parent;
+  GtkWidget *taskbar, *parent, *item;
 
   priv = taskbar_shell_get_instance_private(TASKBAR_SHELL(self));
-  if( (taskbar = priv->get_taskbar(self, win, FALSE)) )
+  if( !(item = g_hash_table_lookup(priv->items, win)) )
+    return;
+
+  g_hash_table_remove(priv->items, win);
+  taskbar = flow_item_get_parent(item);
+  flow_grid_delete_child(taskbar, win);
+  if(!flow_grid_n_children(taskbar) && taskbar != self)
+    flow_grid_delete_child(self,
+        flow_item_get_source(taskbar_get_parent(taskbar)));
+  else if( (parent = taskbar_get_parent(taskbar)) )
+    flow_item_invalidate(parent);
+}
+
+/* app_id or workspace changed: keep the item unless it changes group */
+static void taskbar_shell_item_regroup ( window_t *win, GtkWidget *self )
+{
+  TaskbarShellPrivate *priv;
+  GtkWidget *item;
+
+  priv = taskbar_shell_get_instance_private(TASKBAR_SHELL(self));
+  if( (item = g_hash_table_lookup(priv->items, win)) &&
+      flow_item_get_parent(item) == priv->get_taskbar(self, win, FALSE) )
+    taskbar_shell_item_invalidate(win, self);
+  else
   {
-    flow_grid_delete_child(taskbar, win);
-    if(!flow_grid_n_children(taskbar) && taskbar != self)
-      flow_grid_delete_child(self,
-          flow_item_get_source(taskbar_get_parent(taskbar)));
-    else if( (parent = taskbar_get_parent(taskbar)) )
-      flow_item_invalidate(parent);
+    taskbar_shell_item_destroy(win, self);
+    taskbar_shell_item_init(win, self);
   }
 }
 
@@ -135,6 +156,7 @@ static window_listener_t taskbar_shell_window_listener = {
   .window_new = (void (*)(window_t *, void *))taskbar_shell_item_init,
   .window_invalidate = (void (*)(window_t *, void *))taskbar_shell_item_invalidate,
   .window_destroy = (void (*)(window_t *, void *))taskbar_shell_item_destroy,
+  .window_regroup = (void (*)(window_t *, void *))taskbar_shell_item_regroup,
 };
 
 static void taskbar_shell_ws_invalidate ( workspace_t *ws, GtkWidget *self )
@@ -326,6 +348,7 @@ static void taskbar_shell_init ( TaskbarShell *self )
 
   priv = taskbar_shell_get_instance_private(TASKBAR_SHELL(self));
   priv->get_taskbar = taskbar_get_taskbar;
+  priv->items = g_hash_table_new(g_direct_hash, g_direct_equal);
   priv->timer_h = g_timeout_add(100, (GSourceFunc)flow_grid_update, self);
   priv->title_width = -1;
   wintree_listener_register(&taskbar_shell_window_listener, self);
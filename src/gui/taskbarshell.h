@@ -29,6 +29,7 @@ typedef struct _TaskbarShellPrivate TaskbarShellPrivate;
 struct _TaskbarShellPrivate
 {
   GtkWidget *(*get_taskbar)(GtkWidget *, window_t *, gboolean);
+  GHashTable *items;
   gboolean icons, labels, sort, floating_filter;
   gint rows, cols, filter, title_width, primary_axis, api_id;
   gboolean tooltips;
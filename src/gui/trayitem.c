@@ -184,7 +184,7 @@ static void tray_item_invalidate ( GtkWidget *self )
   g_return_if_fail(IS_TRAY_ITEM(self));
   priv = tray_item_get_instance_private(TRAY_ITEM(self));
 
-  flow_grid_invalidate(priv->tray);
+  flow_grid_invalidate_child(priv->tray, self);
   priv->invalid = TRUE;
 }
 
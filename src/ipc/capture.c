@@ -0,0 +1,205 @@
+/* This entire file is licensed under GNU General Public License v3.0
+ *
+ * Copyright 2025- sfwbar maintainers
+ */
+
+/* Capture and replay of compositor IPC traffic.
+ *
+ * If SFWBAR_IPC_CAPTURE is set, the IPC backend writes every event it
+ * receives and every request/reply pair to the named file, one record per
+ * line:
+ *   E <type> <payload>
+ *   R <type> <request> <reply>
+ * fields are tab separated and escaped with g_strescape. A replay loads
+ * a capture, answers backend requests from the recorded replies and feeds
+ * the recorded events to the backend's handler */
+
+#include <stdio.h>
+#include <string.h>
+#include "ipc/capture.h"
+
+typedef struct {
+  guint32 type;
+  gchar *payload;
+} ipc_event_t;
+
+typedef struct {
+  GPtrArray *replies;
+  guint next;
+} ipc_reply_t;
+
+static FILE *capture;
+static gchar *replay_backend;
+static GPtrArray *replay_events;
+static GHashTable *replay_replies;
+static ipc_replay_handler_t replay_handler;
+static guint replay_pos;
+
+void ipc_capture_open ( const gchar *backend )
+{
+  const gchar *fname;
+
+  if(capture || replay_backend || !(fname = g_getenv("SFWBAR_IPC_CAPTURE")))
+    return;
+
+  if( !(capture = fopen(fname, "w")) )
+  {
+    g_warning("ipc: unable to open capture file '%s'", fname);
+    return;
+  }
+  fprintf(capture, "# sfwbar ipc capture: %s\n", backend);
+  fflush(capture);
+}
+
+void ipc_capture_event ( guint32 type, const gchar *payload )
+{
+  gchar *str;
+
+  if(!capture || !payload)
+    return;
+
+  str = g_strescape(payload, NULL);
+  fprintf(capture, "E\t%u\t%s\n", type, str);
+  fflush(capture);
+  g_free(str);
+}
+
+void ipc_capture_reply ( guint32 type, const gchar *request,
+    const gchar *reply )
+{
+  gchar *req, *rep;
+
+  if(!capture || !request || !reply)
+    return;
+
+  req = g_strescape(request, NULL);
+  rep = g_strescape(reply, NULL);
+  fprintf(capture, "R\t%u\t%s\t%s\n", type, req, rep);
+  fflush(capture);
+  g_free(req);
+  g_free(rep);
+}
+
+static gchar *ipc_reply_key ( guint32 type, const gchar *request )
+{
+  return g_strdup_printf("%u\t%s", type, request);
+}
+
+static void ipc_reply_free ( ipc_reply_t *reply )
+{
+  g_ptr_array_unref(reply->replies);
+  g_free(reply);
+}
+
+static void ipc_event_free ( ipc_event_t *event )
+{
+  g_free(event->payload);
+  g_free(event);
+}
+
+gboolean ipc_replay_load ( const gchar *fname )
+{
+  ipc_event_t *event;
+  ipc_reply_t *reply;
+  gchar *data, **lines, **fields, *key;
+  gint i;
+
+  if(!g_file_get_contents(fname, &data, NULL, NULL))
+    return FALSE;
+
+  lines = g_strsplit(data, "\n", -1);
+  g_free(data);
+  if(!lines[0] || !g_str_has_prefix(lines[0], "# sfwbar ipc capture: "))
+  {
+    g_strfreev(lines);
+    return FALSE;
+  }
+
+  g_free(replay_backend);
+  replay_backend = g_strdup(lines[0] + strlen("# sfwbar ipc capture: "));
+  g_clear_pointer(&replay_events, g_ptr_array_unref);
+  g_clear_pointer(&replay_replies, g_hash_table_destroy);
+  replay_events = g_ptr_array_new_with_free_func(
+      (GDestroyNotify)ipc_event_free);
+  replay_replies = g_hash_table_new_full(g_str_hash, g_str_equal, g_free,
+      (GDestroyNotify)ipc_reply_free);
+  replay_pos = 0;
+
+  for(i=1; lines[i]; i++)
+  {
+    fields = g_strsplit(lines[i], "\t", 4);
+    if(fields[0] && fields[1] && fields[2] && !g_strcmp0(fields[0], "E"))
+    {
+      event = g_malloc0(sizeof(ipc_event_t));
+      event->type = g_ascii_strtoull(fields[1], NULL, 10);
+      event->payload = g_strcompress(fields[2]);
+      g_ptr_array_add(replay_events, event);
+    }
+    else if(fields[0] && fields[1] && fields[2] && fields[3] &&
+        !g_strcmp0(fields[0], "R"))
+    {
+      data = g_strcompress(fields[2]);
+      key = ipc_reply_key(g_ascii_strtoull(fields[1], NULL, 10), data);
+      g_free(data);
+      if( !(reply = g_hash_table_lookup(replay_replies, key)) )
+      {
+        reply = g_malloc0(sizeof(ipc_reply_t));
+        reply->replies = g_ptr_array_new_with_free_func(g_free);
+        g_hash_table_insert(replay_replies, key, reply);
+      }
+      else
+        g_free(key);
+      g_ptr_array_add(reply->replies, g_strcompress(fields[3]));
+    }
+    g_strfreev(fields);
+  }
+  g_strfreev(lines);
+
+  return TRUE;
+}
+
+gboolean ipc_replay_active ( const gchar *backend )
+{
+  return replay_backend && !g_strcmp0(replay_backend, backend);
+}
+
+/* recorded replies to a request are returned in order, the last one is
+ * repeated once they run out */
+gchar *ipc_replay_reply ( guint32 type, const gchar *request )
+{
+  ipc_reply_t *reply;
+  gchar *key;
+
+  if(!replay_replies || !request)
+    return NULL;
+
+  key = ipc_reply_key(type, request);
+  reply = g_hash_table_lookup(replay_replies, key);
+  g_free(key);
+
+  if(!reply || !reply->replies->len)
+    return NULL;
+
+  if(reply->next >= reply->replies->len)
+    return g_strdup(g_ptr_array_index(reply->replies,
+          reply->replies->len-1));
+  return g_strdup(g_ptr_array_index(reply->replies, reply->next++));
+}
+
+void ipc_replay_handler_set ( ipc_replay_handler_t handler )
+{
+  replay_handler = handler;
+}
+
+gboolean ipc_replay_step ( void )
+{
+  ipc_event_t *event;
+
+  if(!replay_events || !replay_handler || replay_pos>=replay_events->len)
+    return FALSE;
+
+  event = g_ptr_array_index(replay_events, replay_pos++);
+  replay_handler(event->type, event->payload);
+
+  return TRUE;
+}
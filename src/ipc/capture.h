@@ -0,0 +1,19 @@
+#ifndef __IPC_CAPTURE_H__
+#define __IPC_CAPTURE_H__
+
+#include <glib.h>
+
+typedef void (*ipc_replay_handler_t) ( guint32 type, gchar *payload );
+
+void ipc_capture_open ( const gchar *backend );
+void ipc_capture_event ( guint32 type, const gchar *payload );
+void ipc_capture_reply ( guint32 type, const gchar *request,
+    const gchar *reply );
+
+gboolean ipc_replay_load ( const gchar *fname );
+gboolean ipc_replay_active ( const gchar *backend );
+gchar *ipc_replay_reply ( guint32 type, const gchar *request );
+void ipc_replay_handler_set ( ipc_replay_handler_t handler );
+gboolean ipc_replay_step ( void );
+
+#endif
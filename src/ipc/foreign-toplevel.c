@@ -4,6 +4,7 @@
  */
 
 #include <gdk/gdkwayland.h>
+#include "trigger.h"
 #include "wintree.h"
 #include "wayland.h"
 #include "gui/monitor.h"
@@ -26,108 +27,215 @@ void foreign_toplevel_activate ( gpointer tl )
         gdk_display_get_default_seat(gdk_display_get_default())));
 }
 
+/* protocol events are accumulated here and applied atomically on done */
+typedef struct _ft_pending {
+  window_t *win;
+  gchar *title;
+  gchar *app_id;
+  guint16 state;
+  gboolean state_set;
+  GList *outputs;
+  gboolean outputs_set;
+  gboolean appended;
+} ft_pending_t;
+
 static void toplevel_handle_app_id(void *data, wlr_fth *tl, const gchar *appid)
 {
-  wintree_set_app_id(tl,appid);
+  ft_pending_t *pending = data;
+
+  g_free(pending->app_id);
+  pending->app_id = g_strdup(appid);
 }
 
 static void toplevel_handle_title(void *data, wlr_fth *tl, const gchar *title)
 {
-  wintree_set_title(tl,title);
+  ft_pending_t *pending = data;
+
+  g_free(pending->title);
+  pending->title = g_strdup(title);
 }
 
 static void toplevel_handle_closed(void *data, wlr_fth *tl)
 {
-  wintree_window_delete(tl);
+  ft_pending_t *pending = data;
+  window_t *win = pending->win;
+
+  if(pending->appended)
+    wintree_window_delete(tl);
+  else
+  {
+    g_free(win->title);
+    g_free(win->appid);
+    g_list_free_full(win->outputs, g_free);
+    g_free(win);
+  }
+  g_free(pending->title);
+  g_free(pending->app_id);
+  g_list_free_full(pending->outputs, g_free);
+  g_free(pending);
   zwlr_foreign_toplevel_handle_v1_destroy(tl);
 }
 
+static gboolean toplevel_outputs_equal ( GList *a, GList *b )
+{
+  GList *iter;
+
+  if(g_list_length(a) != g_list_length(b))
+    return FALSE;
+  for(iter=a; iter; iter=g_list_next(iter))
+    if(!g_list_find_custom(b, iter->data, (GCompareFunc)g_strcmp0))
+      return FALSE;
+  return TRUE;
+}
+
 static void toplevel_handle_done(void *data, wlr_fth *tl)
 {
+  ft_pending_t *pending = data;
+  window_t *win = pending->win;
+  gboolean changed = FALSE, regroup = FALSE, focus;
+  gpointer prev = NULL;
+
+  if(pending->outputs_set &&
+      !toplevel_outputs_equal(win->outputs, pending->outputs))
+  {
+    g_list_free_full(win->outputs, g_free);
+    win->outputs = g_steal_pointer(&pending->outputs);
+    changed = TRUE;
+  }
+  g_list_free_full(g_steal_pointer(&pending->outputs), g_free);
+  pending->outputs_set = FALSE;
+
+  if(pending->title && g_strcmp0(win->title, pending->title))
+  {
+    g_free(win->title);
+    win->title = g_steal_pointer(&pending->title);
+    changed = TRUE;
+  }
+  g_clear_pointer(&pending->title, g_free);
+
+  if(pending->state_set && win->state != pending->state)
+  {
+    win->state = pending->state;
+    changed = TRUE;
+  }
+  pending->state_set = FALSE;
+
+  if(pending->app_id && g_strcmp0(win->appid, pending->app_id))
+  {
+    if(pending->appended)
+      regroup = TRUE;
+    else
+    {
+      win->appid = g_strdup(pending->app_id);
+      if(!win->title)
+        win->title = g_strdup(pending->app_id);
+    }
+  }
+
+  /* the focus moves before listeners are notified, so they see it */
+  if( (focus = !(win->state & WS_FOCUSED) != !wintree_is_focused(win->uid)) )
+    prev = wintree_focus_swap((win->state & WS_FOCUSED)? win->uid : NULL);
+
+  /* notify listeners once per toplevel per done event */
+  if(!pending->appended)
+  {
+    pending->appended = TRUE;
+    wintree_window_add(win);
+  }
+  else if(regroup)
+    wintree_set_app_id(win->uid, pending->app_id);
+  else if(changed || focus)
+    wintree_commit(win);
+  g_clear_pointer(&pending->app_id, g_free);
+
+  if(focus && prev != win->uid)
+    wintree_commit(wintree_from_id(prev));
+  if(focus && (win->state & WS_FOCUSED))
+    trigger_emit("window_focus");
+
+  g_debug("foreign toplevel state for %p: %s%s%s%s", win->uid,
+    win->state & WS_FOCUSED ? "Activated, " : "",
+    win->state & WS_MINIMIZED ? "Minimized, " : "",
+    win->state & WS_MAXIMIZED ? "Maximized, " : "",
+    win->state & WS_FULLSCREEN ? "Fullscreen" : ""
+    );
   wintree_log(tl);
 }
 
 static void toplevel_handle_state(void *data, wlr_fth *tl,
                 struct wl_array *state)
 {
+  ft_pending_t *pending = data;
   uint32_t *entry;
-  window_t *win;
-
-  win = wintree_from_id(tl);
-  if(!win)
-    return;
 
-  win->state = 0;
+  pending->state = 0;
+  pending->state_set = TRUE;
 
   wl_array_for_each(entry, state)
     switch(*entry)
     {
     case ZWLR_FOREIGN_TOPLEVEL_HANDLE_V1_STATE_MINIMIZED:
-      win->state |= WS_MINIMIZED;
+      pending->state |= WS_MINIMIZED;
       break;
     case ZWLR_FOREIGN_TOPLEVEL_HANDLE_V1_STATE_MAXIMIZED:
-      win->state |= WS_MAXIMIZED;
+      pending->state |= WS_MAXIMIZED;
       break;
     case ZWLR_FOREIGN_TOPLEVEL_HANDLE_V1_STATE_FULLSCREEN:
-      win->state |= WS_FULLSCREEN;
+      pending->state |= WS_FULLSCREEN;
       break;
     case ZWLR_FOREIGN_TOPLEVEL_HANDLE_V1_STATE_ACTIVATED:
-      win->state |= WS_FOCUSED;
-      wintree_set_focus(win->uid);
+      pending->state |= WS_FOCUSED;
       break;
     }
-
-  if(wintree_is_focused(win->uid) && !(win->state & WS_FOCUSED))
-    wintree_set_focus(NULL);
-  g_debug("foreign toplevel state for %p: %s%s%s%s", win->uid,
-    win->state & WS_FOCUSED ? "Activated, " : "",
-    win->state & WS_MINIMIZED ? "Minimized, " : "",
-    win->state & WS_MAXIMIZED ? "Maximized, " : "",
-    win->state & WS_FULLSCREEN ? "Fullscreen" : ""
-    );
 }
 
 static void toplevel_handle_parent(void *data, wlr_fth *tl, wlr_fth *pt)
 {
 }
 
+/* the output set is staged on a copy of the window's list until done */
+static GList *toplevel_pending_outputs ( ft_pending_t *pending )
+{
+  if(!pending->outputs_set)
+  {
+    pending->outputs = g_list_copy_deep(pending->win->outputs,
+        (GCopyFunc)g_strdup, NULL);
+    pending->outputs_set = TRUE;
+  }
+  return pending->outputs;
+}
+
 static void toplevel_handle_output_leave(void *data, wlr_fth *tl,
     struct wl_output *output)
 {
+  ft_pending_t *pending = data;
   char *name;
-  window_t *win;
   GList *link;
 
   name = monitor_get_name(monitor_from_wl_output(output));
   if(!name)
     return;
-  win = wintree_from_id(tl);
-  if(!win)
-    return;
-  link = g_list_find_custom(win->outputs,name,(GCompareFunc)g_strcmp0);
+  link = g_list_find_custom(toplevel_pending_outputs(pending), name,
+      (GCompareFunc)g_strcmp0);
   if(!link)
     return;
   g_free(link->data);
-  win->outputs = g_list_delete_link(win->outputs,link);
-  wintree_commit(win);
+  pending->outputs = g_list_delete_link(pending->outputs, link);
 }
 
 static void toplevel_handle_output_enter(void *data, wlr_fth *tl,
     struct wl_output *output)
 {
+  ft_pending_t *pending = data;
   char *name;
-  window_t *win;
 
   name = monitor_get_name(monitor_from_wl_output(output));
   if(!name)
     return;
-  win = wintree_from_id(tl);
-  if(!win)
+  if(g_list_find_custom(toplevel_pending_outputs(pending), name,
+        (GCompareFunc)g_strcmp0))
     return;
-  if(g_list_find_custom(win->outputs,name,(GCompareFunc)g_strcmp0))
-    return;
-  win->outputs = g_list_prepend(win->outputs,g_strdup(name));
-  wintree_commit(win);
+  pending->outputs = g_list_prepend(pending->outputs, g_strdup(name));
 }
 
 static const struct zwlr_foreign_toplevel_handle_v1_listener toplevel_impl = {
@@ -144,13 +252,13 @@ static const struct zwlr_foreign_toplevel_handle_v1_listener toplevel_impl = {
 static void toplevel_manager_handle_toplevel(void *data,
   struct zwlr_foreign_toplevel_manager_v1 *toplevel_manager, wlr_fth *tl)
 {
-  window_t *win;
+  ft_pending_t *pending;
 
-  win = wintree_window_init();
-  win->uid = tl;
-  wintree_window_append(win);
+  pending = g_malloc0(sizeof(ft_pending_t));
+  pending->win = wintree_window_init();
+  pending->win->uid = tl;
 
-  zwlr_foreign_toplevel_handle_v1_add_listener(tl, &toplevel_impl, NULL);
+  zwlr_foreign_toplevel_handle_v1_add_listener(tl, &toplevel_impl, pending);
 }
 
 static void toplevel_manager_handle_finished(void *data,
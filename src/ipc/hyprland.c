@@ -4,6 +4,7 @@
  */
 
 #include "wintree.h"
+#include "ipc/capture.h"
 #include "util/json.h"
 
 #define hypr_ipc_parse_id(x, y) GSIZE_TO_POINTER(g_ascii_strtoull(x, y, 16))
@@ -30,11 +31,23 @@ static gpointer hypr_ipc_workspace_id ( json_object *json )
 
 static gboolean hypr_ipc_request ( gchar *addr, gchar *command, json_object **json )
 {
+  gchar *reply;
   gint sock;
 
   if(!command)
     return FALSE;
 
+  if(ipc_replay_active("hyprland"))
+  {
+    if(json)
+    {
+      reply = ipc_replay_reply(0, command);
+      *json = reply? json_tokener_parse(reply) : NULL;
+      g_free(reply);
+    }
+    return TRUE;
+  }
+
   if( (sock = socket_connect(addr, 1000))==-1 )
   {
     g_debug("hypr: can't open socket");
@@ -49,7 +62,11 @@ static gboolean hypr_ipc_request ( gchar *addr, gchar *command, json_object **js
   }
 
   if(json)
+  {
     *json = recv_json(sock, -1);
+    if(*json)
+      ipc_capture_reply(0, command, json_object_to_json_string(*json));
+  }
 
   close(sock);
   return TRUE;
@@ -514,6 +531,43 @@ static struct workspace_api hypr_workspace_api = {
     .get_geom = hypr_ipc_get_geom
 };
 
+static void hypr_ipc_event_handle ( gchar *event )
+{
+  gchar *ptr;
+
+  g_debug("hypr event: %s", event);
+  if(!strncmp(event, "activewindowv2>>", 16))
+    hypr_ipc_handle_focus(event+16);
+  else if(!strncmp(event, "windowtitlev2>>", 15))
+    hypr_ipc_title_handle(event+15);
+  else if(!strncmp(event, "openwindow>>", 12))
+  {
+    hypr_ipc_get_clients(hypr_ipc_parse_id(event+12, NULL));
+    hypr_ipc_window_place(hypr_ipc_parse_id(event+12, NULL));
+  }
+  else if(!strncmp(event, "closewindow>>", 13))
+    wintree_window_delete(hypr_ipc_parse_id(event+13, NULL));
+  else if(!strncmp(event, "fullscreen>>",12))
+    hypr_ipc_set_maximized(g_ascii_digit_value(*(event+12)));
+  else if(!strncmp(event, "movewindowv2>>", 14))
+    hypr_ipc_track_workspace(event+14);
+  else if(!strncmp(event, "workspacev2>>", 13))
+    workspace_change_focus(hypr_ipc_parse_ws(event+13, NULL));
+  else if(!strncmp(event, "focusedmonv2>>", 14))
+  {
+    if( (ptr = strchr(event+14, ',')) )
+      workspace_change_focus(hypr_ipc_parse_ws(ptr+1, NULL));
+  }
+  else if(!strncmp(event, "createworkspacev2>>", 19))
+    hypr_ipc_workspace_new(event+19);
+  else if(!strncmp(event, "changefloatingmode>>", 20))
+    hypr_ipc_floating_set(event+20);
+  else if(!strncmp(event, "destroyworkspacev2>>", 20))
+    workspace_unref(hypr_ipc_parse_ws(event+20, NULL));
+  else if(!strncmp(event, "urgent>>", 8))
+    hypr_ipc_handle_urgent(event+8);
+}
+
 static gboolean hypr_ipc_event ( GIOChannel *chan, GIOCondition cond,
     gpointer data)
 {
@@ -524,37 +578,8 @@ static gboolean hypr_ipc_event ( GIOChannel *chan, GIOCondition cond,
   {
     if((ptr=strchr(event, '\n')))
       *ptr=0;
-    g_debug("hypr event: %s", event);
-    if(!strncmp(event, "activewindowv2>>", 16))
-      hypr_ipc_handle_focus(event+16);
-    else if(!strncmp(event, "windowtitlev2>>", 15))
-      hypr_ipc_title_handle(event+15);
-    else if(!strncmp(event, "openwindow>>", 12))
-    {
-      hypr_ipc_get_clients(hypr_ipc_parse_id(event+12, NULL));
-      hypr_ipc_window_place(hypr_ipc_parse_id(event+12, NULL));
-    }
-    else if(!strncmp(event, "closewindow>>", 13))
-      wintree_window_delete(hypr_ipc_parse_id(event+13, NULL));
-    else if(!strncmp(event, "fullscreen>>",12))
-      hypr_ipc_set_maximized(g_ascii_digit_value(*(event+12)));
-    else if(!strncmp(event, "movewindowv2>>", 14))
-      hypr_ipc_track_workspace(event+14);
-    else if(!strncmp(event, "workspacev2>>", 13))
-      workspace_change_focus(hypr_ipc_parse_ws(event+13, NULL));
-    else if(!strncmp(event, "focusedmonv2>>", 14))
-    {
-      if( (ptr = strchr(event+14, ',')) )
-        workspace_change_focus(hypr_ipc_parse_ws(ptr+1, NULL));
-    }
-    else if(!strncmp(event, "createworkspacev2>>", 19))
-      hypr_ipc_workspace_new(event+19);
-    else if(!strncmp(event, "changefloatingmode>>", 20))
-      hypr_ipc_floating_set(event+20);
-    else if(!strncmp(event, "destroyworkspacev2>>", 20))
-      workspace_unref(hypr_ipc_parse_ws(event+20, NULL));
-    else if(!strncmp(event, "urgent>>", 8))
-      hypr_ipc_handle_urgent(event+8);
+    ipc_capture_event(0, event);
+    hypr_ipc_event_handle(event);
     g_free(event);
     (void)g_io_channel_read_line(chan, &event, NULL, NULL, NULL);
   }
@@ -562,6 +587,15 @@ static gboolean hypr_ipc_event ( GIOChannel *chan, GIOCondition cond,
   return TRUE;
 }
 
+static void hypr_ipc_replay_event ( guint32 type, gchar *payload )
+{
+  gchar *event;
+
+  event = g_strdup(payload);
+  hypr_ipc_event_handle(event);
+  g_free(event);
+}
+
 void hypr_ipc_init ( void )
 {
   gchar *sockaddr;
@@ -570,7 +604,17 @@ void hypr_ipc_init ( void )
   if(wintree_api_check())
     return;
 
+  if(ipc_replay_active("hyprland"))
+  {
+    hypr_ipc_get_clients(NULL);
+    workspace_api_register(&hypr_workspace_api);
+    wintree_api_register(&hypr_wintree_api);
+    hypr_ipc_pager_populate();
+    ipc_replay_handler_set(hypr_ipc_replay_event);
+    return;
+  }
 
+  ipc_capture_open("hyprland");
   ipc_sockaddr = g_build_filename(g_get_user_runtime_dir(), "hypr",
       g_getenv("HYPRLAND_INSTANCE_SIGNATURE"), ".socket.sock", NULL);
   if(!hypr_ipc_get_clients(NULL))
@@ -8,6 +8,7 @@
 #include "trigger.h"
 #include "wintree.h"
 #include "gui/bar.h"
+#include "ipc/capture.h"
 #include "util/json.h"
 #include "vm/vm.h"
 
@@ -76,6 +77,15 @@ static json_object *sway_ipc_request ( gchar *command, gint32 type )
 {
   gint sock;
   json_object *json;
+  gchar *reply;
+
+  if(ipc_replay_active("sway"))
+  {
+    reply = ipc_replay_reply(type, command);
+    json = reply? json_tokener_parse(reply) : NULL;
+    g_free(reply);
+    return json;
+  }
 
   sock = sway_ipc_open(3000);
   if(sock==-1)
@@ -83,6 +93,8 @@ static json_object *sway_ipc_request ( gchar *command, gint32 type )
   sway_ipc_send(sock, type, command);
   json = sway_ipc_poll(sock, NULL);
   close(sock);
+  if(json)
+    ipc_capture_reply(type, command, json_object_to_json_string(json));
 
   return json;
 }
@@ -229,8 +241,8 @@ static workspace_t *sway_ipc_workspace_new ( struct json_object *obj )
   }
   else
   {
-    workspace_ref(ws->id);
-    ws->id = id;
+    workspace_set_id(ws, id);
+    workspace_ref(id);
   }
 
   if(json_bool_by_name(obj, "focused", FALSE))
@@ -379,6 +391,32 @@ static void sway_ipc_scan_input ( struct json_object *obj, guint32 etype )
   trigger_emit("sway");
 }
 
+static void sway_ipc_event_handle ( struct json_object *obj, guint32 etype )
+{
+  if(etype==0x80000000)
+    sway_ipc_workspace_event(obj);
+  else if(etype==0x80000004)
+  {
+    bar_set_visibility(NULL, json_string_by_name(obj, "id"),
+        *(json_string_by_name(obj, "mode")));
+    if(g_strcmp0(json_string_by_name(obj, "hidden_state"), "hide"))
+    {
+      sway_ipc_command("bar %s hidden_state hide",
+          json_string_by_name(obj, "id"));
+      trigger_emit("switcher_forward");
+    }
+  }
+  else if(etype==0x00000004)
+    sway_traverse_tree(obj, NULL, NULL);
+  else if(etype==0x80000003)
+    sway_ipc_window_event(obj);
+  else if(etype==0x80000014)
+    bar_set_visibility(NULL, json_string_by_name(obj, "id"),
+        json_bool_by_name(obj, "visible_by_modifier", FALSE)?'v':'x');
+
+  sway_ipc_scan_input(obj, etype);
+}
+
 static gboolean sway_ipc_event ( GIOChannel *chan, GIOCondition cond,
     gpointer data )
 {
@@ -389,33 +427,23 @@ static gboolean sway_ipc_event ( GIOChannel *chan, GIOCondition cond,
     return FALSE;
 
   while ( (obj=sway_ipc_poll(main_ipc, &etype)) )
-  { 
-    if(etype==0x80000000)
-      sway_ipc_workspace_event(obj);
-    else if(etype==0x80000004)
-    {
-      bar_set_visibility(NULL, json_string_by_name(obj, "id"),
-          *(json_string_by_name(obj, "mode")));
-      if(g_strcmp0(json_string_by_name(obj, "hidden_state"), "hide"))
-      {
-        sway_ipc_command("bar %s hidden_state hide",
-            json_string_by_name(obj, "id"));
-        trigger_emit("switcher_forward");
-      }
-    }
-    else if(etype==0x00000004)
-      sway_traverse_tree(obj, NULL, NULL);
-    else if(etype==0x80000003)
-      sway_ipc_window_event(obj);
-    else if(etype==0x80000014)
-      bar_set_visibility(NULL, json_string_by_name(obj, "id"),
-          json_bool_by_name(obj, "visible_by_modifier", FALSE)?'v':'x');
+  {
+    ipc_capture_event(etype, json_object_to_json_string(obj));
+    sway_ipc_event_handle(obj, etype);
+    json_object_put(obj);
+  }
+  return TRUE;
+}
 
-    sway_ipc_scan_input(obj, etype);
+static void sway_ipc_replay_event ( guint32 etype, gchar *payload )
+{
+  struct json_object *obj;
 
+  if( (obj = json_tokener_parse(payload)) )
+  {
+    sway_ipc_event_handle(obj, etype);
     json_object_put(obj);
   }
-  return TRUE;
 }
 
 /* Window API */
@@ -572,10 +600,26 @@ void sway_ipc_init ( void )
   struct json_object *obj;
   gint sock;
 
+  if(!wintree_api_check() && ipc_replay_active("sway"))
+  {
+    workspace_api_register(&sway_workspace_api);
+    wintree_api_register(&sway_wintree_api);
+    main_ipc = -1;
+    sway_ipc_workspace_populate();
+    if( (obj = sway_ipc_request("", 4)) )
+    {
+      sway_traverse_tree(obj, NULL, NULL);
+      json_object_put(obj);
+    }
+    ipc_replay_handler_set(sway_ipc_replay_event);
+    return;
+  }
+
   if(wintree_api_check() || ((sock=sway_ipc_open(1000))==-1) )
     return;
   workspace_api_register(&sway_workspace_api);
   wintree_api_register(&sway_wintree_api);
+  ipc_capture_open("sway");
 
   sway_ipc_send(sock, 0, "bar hidden_state hide");
   if( (obj = sway_ipc_poll(sock, NULL)) )
@@ -584,6 +628,7 @@ void sway_ipc_init ( void )
   sway_ipc_send(sock, 4, "");
   if( (obj = sway_ipc_poll(sock, NULL)) )
   {
+    ipc_capture_reply(4, "", json_object_to_json_string(obj));
     sway_traverse_tree(obj, NULL, NULL);
     json_object_put(obj);
   }
@@ -0,0 +1,126 @@
+/* This entire file is licensed under GNU General Public License v3.0
+ *
+ * Copyright 2025- sfwbar maintainers
+ */
+
+/* sfwbar-ipc-replay: feed a compositor IPC capture (recorded by running
+ * sfwbar with SFWBAR_IPC_CAPTURE=FILE) through the IPC backend and report
+ * event throughput, allocations per event and time spent in each workspace
+ * and window listener. Without a config, only the backend and the window
+ * and workspace registries are exercised. With a config and a display, the
+ * widgets it creates (taskbars, pagers, switchers) are exercised as well */
+
+#include <stdio.h>
+#include "sfwbar.h"
+#include "bench.h"
+#include "wayland.h"
+#include "config/config.h"
+#include "gui/css.h"
+#include "gui/monitor.h"
+#include "ipc/capture.h"
+#include "ipc/sway.h"
+#include "util/profile.h"
+
+static gchar *confname;
+
+static GOptionEntry entries[] = {
+  { "config", 'c', 0, G_OPTION_ARG_FILENAME, &confname,
+    "Create widgets from a config file (needs a display)", "CONFIG" },
+  { NULL }
+};
+
+static gint ipc_replay_entry_comp ( profile_entry_t *e1, profile_entry_t *e2 )
+{
+  return (e1->time < e2->time) - (e1->time > e2->time);
+}
+
+static void ipc_replay_report ( gint events, gint64 elapsed, gint allocs )
+{
+  profile_entry_t *entry;
+  GList *list, *iter;
+
+  printf("%d events in %.3f ms, %.0f events/s", events, elapsed/1e6,
+      elapsed? events*1e9/elapsed : 0.0);
+  if(bench_allocs_supported() && events)
+    printf(", %.1f allocs/event", (gdouble)allocs/events);
+  printf("\n");
+
+  list = g_list_sort(profile_get(), (GCompareFunc)ipc_replay_entry_comp);
+  if(list)
+    printf("%-24s %-20s %10s %12s %10s\n", "listener", "method", "calls",
+        "total (us)", "ns/call");
+  for(iter=list; iter; iter=g_list_next(iter))
+  {
+    entry = iter->data;
+    printf("%-24s %-20s %10" G_GUINT64_FORMAT " %12.1f %10.0f\n",
+        entry->type!=G_TYPE_NONE? g_type_name(entry->type) : "-",
+        entry->name, entry->calls, entry->time/1e3,
+        (gdouble)entry->time/entry->calls);
+  }
+  g_list_free(list);
+}
+
+int main ( int argc, gchar **argv )
+{
+  GOptionContext *optc;
+  GError *error = NULL;
+  gint64 start, elapsed;
+  gint events = 0, allocs;
+
+  optc = g_option_context_new("FILE - replay a compositor IPC capture");
+  g_option_context_add_main_entries(optc, entries, NULL);
+  if(!g_option_context_parse(optc, &argc, &argv, &error) || argc!=2)
+  {
+    fprintf(stderr, "%s", error? error->message : "");
+    fprintf(stderr, "\n%s", g_option_context_get_help(optc, TRUE, NULL));
+    return 1;
+  }
+  g_option_context_free(optc);
+
+  if(!ipc_replay_load(argv[1]))
+  {
+    fprintf(stderr, "%s: not an sfwbar ipc capture\n", argv[1]);
+    return 1;
+  }
+
+  config_init();
+  expr_lib_init();
+  action_lib_init();
+
+  if(confname)
+  {
+    if(!gtk_init_check(&argc, &argv))
+    {
+      fprintf(stderr, "no display available, can't load %s\n", confname);
+      return 1;
+    }
+    wayland_init();
+    css_init(NULL);
+    monitor_init(NULL);
+  }
+
+  sway_ipc_init();
+  hypr_ipc_init();
+
+  if(confname && !config_parse(confname, NULL, NULL))
+    fprintf(stderr, "%s: no panel defined\n", confname);
+  while(g_main_context_iteration(NULL, FALSE));
+
+  /* a single pass: replaying the capture again would run onto a window
+   * and workspace registry that still holds everything from the first one */
+  profile_enabled = TRUE;
+  allocs = -bench_allocs();
+  start = profile_now();
+  while(ipc_replay_step())
+  {
+    while(g_main_context_iteration(NULL, FALSE));
+    events++;
+  }
+  elapsed = profile_now() - start;
+  allocs += bench_allocs();
+  profile_enabled = FALSE;
+
+  ipc_replay_report(events, elapsed, allocs);
+
+  return 0;
+}
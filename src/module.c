@@ -15,6 +15,7 @@
 static GList *module_list;
 static GHashTable *interfaces;
 static GList *invalidators;
+static GHashTable *module_func_triggers;
 
 void module_interface_select ( gchar *interface )
 {
@@ -101,12 +102,50 @@ gchar *module_interface_provider_get ( gchar *interface )
   return g_strdup(list->active->provider);
 }
 
+void module_func_changed ( gchar *name )
+{
+  vm_function_t *func;
+
+  if(name && (func = vm_func_lookup(name)) )
+    expr_dep_trigger(func->quark);
+}
+
+static void module_func_trigger_cb ( gchar *name, vm_store_t *store )
+{
+  module_func_changed(name);
+}
+
+void module_functions_add ( ModuleFunctionV1 *funcs )
+{
+  const gchar *name;
+  gint i, j;
+
+  if(!module_func_triggers)
+    module_func_triggers = g_hash_table_new(g_direct_hash, g_direct_equal);
+
+  /* backends re-add their functions on every activation, the triggers
+   * of an entry only need to be registered once */
+  for(i=0; funcs && funcs[i].name; i++)
+  {
+    vm_func_add(funcs[i].name, funcs[i].function,
+        funcs[i].type != MODULE_FUNC_POLL);
+    if(funcs[i].type != MODULE_FUNC_PUSH || !funcs[i].triggers ||
+        !g_hash_table_add(module_func_triggers, &funcs[i]))
+      continue;
+    name = g_intern_string(funcs[i].name);
+    for(j=0; funcs[i].triggers[j]; j++)
+      trigger_add(funcs[i].triggers[j],
+          (trigger_func_t)module_func_trigger_cb, (gchar *)name);
+  }
+}
+
 gboolean module_load ( gchar *name )
 {
   GModule *module;
   ModuleInvalidator invalidator;
   ModuleInitializer init;
   ModuleInterfaceV1 *iface;
+  ModuleFunctionV1 *funcs;
   gint64 *sig;
   guint16 *ver;
   gchar *fname, *path;
@@ -138,7 +177,7 @@ gboolean module_load ( gchar *name )
     return FALSE;
   }
   if(!g_module_symbol(module,"sfwbar_module_version",(void **)&ver) ||
-      !ver || *ver != MODULE_API_VERSION )
+      !ver || *ver < MODULE_API_VERSION_MIN || *ver > MODULE_API_VERSION )
   {
     g_debug("module: invalid version for %s",name);
     return FALSE;
@@ -153,6 +192,10 @@ gboolean module_load ( gchar *name )
       return FALSE;
   }
 
+  if(*ver >= 4 &&
+      g_module_symbol(module, "sfwbar_module_functions", (void **)&funcs))
+    module_functions_add(funcs);
+
   if(g_module_symbol(module,"sfwbar_module_invalidate",(void **)&invalidator))
     invalidators = g_list_prepend(invalidators,invalidator);
 
@@ -3,8 +3,10 @@
 #define __MODULE_H__
 
 #include <glib.h>
+#include "vm/vm.h"
 
-#define MODULE_API_VERSION 3
+#define MODULE_API_VERSION 4
+#define MODULE_API_VERSION_MIN 3
 
 typedef void (*ModuleInvalidator)( void );
 typedef gboolean (*ModuleInitializer)( void );
@@ -24,8 +26,26 @@ typedef struct {
   ModuleInterfaceV1 *active;
 } ModuleInterfaceList;
 
+typedef enum {
+  MODULE_FUNC_POLL = 0,   /* value may change at any time, re-evaluate on poll */
+  MODULE_FUNC_PUSH = 1,   /* value changes only when the module signals it */
+  MODULE_FUNC_ACTION = 2,
+} ModuleFuncType;
+
+/* API v4: modules may export a NULL terminated array of these as
+ * sfwbar_module_functions. PUSH functions are re-evaluated only when one of
+ * the listed triggers is emitted or the module calls module_func_changed() */
+typedef struct {
+  gchar *name;
+  vm_func_t function;
+  ModuleFuncType type;
+  gchar **triggers;
+} ModuleFunctionV1;
+
 gboolean module_load ( gchar *name );
 void module_invalidate_all ( void );
+void module_functions_add ( ModuleFunctionV1 *funcs );
+void module_func_changed ( gchar *name );
 void module_interface_select ( gchar *interface );
 void module_interface_activate ( ModuleInterfaceV1 *iface );
 void module_interface_deactivate ( ModuleInterfaceV1 *iface );
@@ -7,6 +7,7 @@
 #include <fcntl.h>
 #include <sys/stat.h>
 #include <glob.h>
+#include <unistd.h>
 #include "client.h"
 #include "config/config.h"
 #include "util/json.h"
@@ -17,6 +18,25 @@ static GList *file_list;
 static GData *scan_list;
 static GHashTable *trigger_list;
 
+typedef void (*scanner_native_parser_t)( ScanFile *, gchar * );
+
+static void scanner_native_procstat ( ScanFile *, gchar * );
+static void scanner_native_meminfo ( ScanFile *, gchar * );
+static void scanner_native_netdev ( ScanFile *, gchar * );
+static void scanner_native_diskstats ( ScanFile *, gchar * );
+static gboolean scanner_file_native ( ScanFile *file );
+
+static const struct {
+  gchar *fname;
+  gchar *prefix;
+  scanner_native_parser_t parse;
+} scanner_native[] = {
+  { "/proc/stat", "ProcStat", scanner_native_procstat },
+  { "/proc/meminfo", "MemInfo", scanner_native_meminfo },
+  { "/proc/net/dev", "NetDev", scanner_native_netdev },
+  { "/proc/diskstats", "DiskStats", scanner_native_diskstats },
+};
+
 void scanner_file_attach ( const gchar *trigger, ScanFile *file )
 {
   if(!trigger_list)
@@ -44,6 +64,7 @@ void scanner_file_merge ( ScanFile *keep, ScanFile *temp )
   keep->vars = g_list_concat(keep->vars, temp->vars);
 
   g_free(temp->fname);
+  g_free(temp->prefix);
   g_free(temp);
 }
 
@@ -57,7 +78,8 @@ ScanFile *scanner_file_new ( gint source, gchar *fname,
     iter = NULL;
   else
     for(iter=file_list;iter;iter=g_list_next(iter))
-      if(!g_strcmp0(fname,((ScanFile *)(iter->data))->fname))
+      if(((ScanFile *)(iter->data))->source < SO_PROCSTAT &&
+          !g_strcmp0(fname,((ScanFile *)(iter->data))->fname))
         break;
 
   if(iter)
@@ -90,6 +112,39 @@ ScanFile *scanner_file_new ( gint source, gchar *fname,
   return file;
 }
 
+ScanFile *scanner_file_native_new ( gint source, gchar *prefix )
+{
+  ScanFile *file;
+  GList *iter;
+
+  g_return_val_if_fail(source >= SO_PROCSTAT && source <= SO_DISKSTATS, NULL);
+
+  if(!prefix || !*prefix)
+    prefix = scanner_native[source - SO_PROCSTAT].prefix;
+
+  /* native files are keyed by source and prefix, not by file name */
+  for(iter=file_list; iter; iter=g_list_next(iter))
+  {
+    file = iter->data;
+    if(file->source == source && !g_strcmp0(file->prefix, prefix))
+      return file;
+  }
+
+  file = g_malloc0(sizeof(ScanFile));
+  file->fname = g_strdup(scanner_native[source - SO_PROCSTAT].fname);
+  file->prefix = g_strdup(prefix);
+  file->source = source;
+  file->flags = VF_NOGLOB | VF_POPULATE;
+  file_list = g_list_append(file_list, file);
+
+  /* populate the variables, so expressions can bind to them. Variables
+   * are only created here, devices that appear later are ignored */
+  scanner_file_native(file);
+  file->flags &= ~VF_POPULATE;
+
+  return file;
+}
+
 void scanner_var_free ( ScanVar *var )
 {
   if(var->file)
@@ -141,6 +196,7 @@ void scanner_var_new ( gchar *name, ScanFile *file, gchar *pattern,
       g_debug("scanner: new set: '%s' in %p", g_quark_to_string(quark),
           var->expr? var->expr->store : NULL);
       var->vstate = 1;
+      var->version++;
       expr_dep_trigger(quark);
       break;
     case G_TOKEN_JSON:
@@ -150,7 +206,7 @@ void scanner_var_new ( gchar *name, ScanFile *file, gchar *pattern,
     case G_TOKEN_REGEX:
       if(var->definition)
         g_regex_unref(var->definition);
-      var->definition = g_regex_new(pattern, 0, 0, NULL);
+      var->definition = regex_cache_get(pattern);
       break;
   }
 
@@ -184,6 +240,7 @@ void scanner_var_values_update ( ScanVar *var, gchar *value)
 
   if(var->multi!=VT_FIRST || !var->count || var->type==G_TOKEN_SET)
   {
+    var->changed = var->changed || g_strcmp0(var->str, value);
     g_free(var->str);
     var->str = value;
     switch(var->multi)
@@ -210,6 +267,18 @@ void scanner_var_values_update ( ScanVar *var, gchar *value)
   var->invalid = FALSE;
 }
 
+/* bump the version if the value changed since the last commit, so
+ * expressions polling the variable can skip re-evaluation */
+static void scanner_var_commit ( ScanVar *var )
+{
+  if(var->changed || var->val != var->vval)
+  {
+    var->version++;
+    var->vval = var->val;
+    var->changed = FALSE;
+  }
+}
+
 void scanner_update_json ( struct json_object *obj, ScanFile *file )
 {
   GList *node;
@@ -290,7 +359,7 @@ GIOStatus scanner_file_update ( GIOChannel *in, ScanFile *file, gsize *size )
   for(node=file->vars;node!=NULL;node=g_list_next(node))
   {
     ((ScanVar *)node->data)->invalid = FALSE;
-    ((ScanVar *)node->data)->vstate = TRUE;
+    scanner_var_commit(node->data);
   }
 
   g_debug("channel status %d, (%s)",status,file->fname?file->fname:"(null)");
@@ -348,6 +417,187 @@ gboolean scanner_file_exec ( ScanFile *file )
   return TRUE;
 }
 
+static gchar *scanner_native_token ( gchar **ptr )
+{
+  gchar *start;
+
+  while(**ptr==' ' || **ptr=='\t')
+    (*ptr)++;
+  if(!**ptr)
+    return NULL;
+
+  start = *ptr;
+  while(**ptr && **ptr!=' ' && **ptr!='\t')
+    (*ptr)++;
+  if(**ptr)
+    *(*ptr)++ = '\0';
+
+  return start;
+}
+
+/* create variable <prefix>[_<device>]_<field> and record it under the row
+ * key and field index the parser will look it up by */
+static ScanVar *scanner_native_var_new ( ScanFile *file, const gchar *row,
+    guint index, const gchar *device, const gchar *field )
+{
+  GPtrArray *vars;
+  ScanVar *var;
+  GQuark quark;
+  gchar *name, *ptr;
+
+  name = device? g_strconcat(file->prefix, "_", device, "_", field, NULL) :
+    g_strconcat(file->prefix, "_", field, NULL);
+  for(ptr=name; *ptr; ptr++)
+    if(!g_ascii_isalnum(*ptr))
+      *ptr = '_';
+
+  quark = scanner_parse_identifier(name, NULL);
+  if( !(var = g_datalist_id_get_data(&scan_list, quark)) )
+  {
+    scanner_var_new(name, file, NULL, G_TOKEN_GRAB, VT_LAST, NULL);
+    if( (var = g_datalist_id_get_data(&scan_list, quark)) )
+      scanner_var_reset(var, NULL);
+  }
+  g_free(name);
+  if(!var || var->file != file)
+    return NULL;
+
+  if(!file->native)
+    file->native = g_hash_table_new_full(g_str_hash, g_str_equal, g_free,
+        (GDestroyNotify)g_ptr_array_unref);
+  if( !(vars = g_hash_table_lookup(file->native, row)) )
+  {
+    vars = g_ptr_array_new();
+    g_hash_table_insert(file->native, g_strdup(row), vars);
+  }
+  if(vars->len <= index)
+    g_ptr_array_set_size(vars, index + 1);
+  g_ptr_array_index(vars, index) = var;
+
+  return var;
+}
+
+/* set the value of a field, variables are only created while populating,
+ * afterwards rows that weren't seen then (i.e. new devices) are skipped */
+static void scanner_native_set ( ScanFile *file, const gchar *row,
+    guint index, const gchar *device, const gchar *field, gchar *value )
+{
+  GPtrArray *vars;
+  ScanVar *var;
+
+  if(file->native && (vars = g_hash_table_lookup(file->native, row)) &&
+      index < vars->len)
+    var = g_ptr_array_index(vars, index);
+  else if(file->flags & VF_POPULATE)
+    var = scanner_native_var_new(file, row, index, device, field);
+  else
+    var = NULL;
+
+  if(var)
+    scanner_var_values_update(var, g_strdup(value));
+}
+
+static void scanner_native_procstat ( ScanFile *file, gchar *line )
+{
+  static const gchar *fields[] = { "user", "nice", "system", "idle",
+    "iowait", "irq", "softirq", "steal", "guest", "guest_nice", NULL };
+  gchar *key, *tok;
+  gint i;
+
+  if( !(key = scanner_native_token(&line)) )
+    return;
+
+  if(!strncmp(key, "cpu", 3))
+  {
+    for(i=0; fields[i] && (tok = scanner_native_token(&line)); i++)
+      scanner_native_set(file, key, i, key[3]? key : NULL, fields[i], tok);
+  }
+  else if( (tok = scanner_native_token(&line)) )
+    scanner_native_set(file, key, 0, NULL, key, tok);
+}
+
+static void scanner_native_meminfo ( ScanFile *file, gchar *line )
+{
+  gchar *key, *tok, *ptr;
+
+  if( !(key = scanner_native_token(&line)) ||
+      !(tok = scanner_native_token(&line)) )
+    return;
+  if( (ptr = strchr(key, ':')) )
+    *ptr = '\0';
+  scanner_native_set(file, key, 0, NULL, key, tok);
+}
+
+static void scanner_native_netdev ( ScanFile *file, gchar *line )
+{
+  static const gchar *fields[] = { "rx_bytes", "rx_packets", "rx_errs",
+    "rx_drop", "rx_fifo", "rx_frame", "rx_compressed", "rx_multicast",
+    "tx_bytes", "tx_packets", "tx_errs", "tx_drop", "tx_fifo", "tx_colls",
+    "tx_carrier", "tx_compressed", NULL };
+  gchar *iface, *tok, *ptr;
+  gint i;
+
+  if( !(ptr = strchr(line, ':')) )
+    return;
+  *ptr++ = '\0';
+  if( !(iface = scanner_native_token(&line)) )
+    return;
+
+  for(i=0; fields[i] && (tok = scanner_native_token(&ptr)); i++)
+    scanner_native_set(file, iface, i, iface, fields[i], tok);
+}
+
+static void scanner_native_diskstats ( ScanFile *file, gchar *line )
+{
+  static const gchar *fields[] = { "reads", "reads_merged", "sectors_read",
+    "ms_reading", "writes", "writes_merged", "sectors_written", "ms_writing",
+    "io_in_progress", "ms_io", "ms_weighted_io", NULL };
+  gchar *dev, *tok;
+  gint i;
+
+  if( !scanner_native_token(&line) || !scanner_native_token(&line) ||
+      !(dev = scanner_native_token(&line)) )
+    return;
+
+  for(i=0; fields[i] && (tok = scanner_native_token(&line)); i++)
+    scanner_native_set(file, dev, i, dev, fields[i], tok);
+}
+
+/* parse a procfs file with a fixed layout, without any regex matching */
+static gboolean scanner_file_native ( ScanFile *file )
+{
+  GString *buf;
+  GList *iter;
+  gchar chunk[4096], *line, *next;
+  gssize len;
+  gint in;
+
+  if( (in = open(file->fname, O_RDONLY)) == -1 )
+    return FALSE;
+
+  buf = g_string_sized_new(sizeof(chunk));
+  while( (len = read(in, chunk, sizeof(chunk))) > 0 )
+    g_string_append_len(buf, chunk, len);
+  close(in);
+
+  g_list_foreach(file->vars, (GFunc)scanner_var_reset, NULL);
+  for(line=buf->str; line && *line; line=next)
+  {
+    if( (next = strchr(line, '\n')) )
+      *next++ = '\0';
+    scanner_native[file->source - SO_PROCSTAT].parse(file, line);
+  }
+  g_string_free(buf, TRUE);
+
+  for(iter=file->vars; iter; iter=g_list_next(iter))
+  {
+    ((ScanVar *)iter->data)->invalid = FALSE;
+    scanner_var_commit(iter->data);
+  }
+
+  return TRUE;
+}
+
 /* update all variables in a file (by glob) */
 gboolean scanner_file_glob ( ScanFile *file )
 {
@@ -365,6 +615,8 @@ gboolean scanner_file_glob ( ScanFile *file )
     return FALSE;
   if(file->source == SO_EXEC)
     return scanner_file_exec(file);
+  if(file->source >= SO_PROCSTAT)
+    return scanner_file_native(file);
   if((file->flags & VF_NOGLOB)||(file->source != SO_FILE))
   {
     dnames[0] = file->fname;
@@ -454,14 +706,7 @@ static ScanVar *scanner_var_update ( GQuark id, gboolean update,
   if(!(var = g_datalist_id_get_data(&scan_list, id)) )
     return NULL;
 
-  if(!update || (!var->invalid && var->type != G_TOKEN_SET))
-  {
-    if(expr)
-      expr->vstate = expr->vstate || var->vstate;
-    return var;
-  }
-
-  if(var->type == G_TOKEN_SET)
+  if(update && var->type == G_TOKEN_SET)
   {
     if(!var->inuse)
     {
@@ -471,25 +716,30 @@ static ScanVar *scanner_var_update ( GQuark id, gboolean update,
       var->expr->parent = NULL;
       var->inuse = FALSE;
       var->vstate = var->expr->vstate;
-      if(expr)
-        expr->vstate = expr->vstate || var->expr->vstate;
       if(var->invalid)
         scanner_var_reset(var, NULL);
       scanner_var_values_update(var,g_strdup(var->expr->cache));
+      scanner_var_commit(var);
       var->invalid = FALSE;
     }
   }
-  else
-  {
+  else if(update && var->invalid)
     scanner_file_glob(var->file);
-    if(expr)
-      expr->vstate = TRUE;
-    var->vstate = TRUE;
-  }
+
+  if(expr && var->type == G_TOKEN_SET)
+    expr->vstate = expr->vstate || var->vstate;
 
   return var;
 }
 
+/* the version of a variable after bringing it up to date */
+guint scanner_var_version ( GQuark id )
+{
+  ScanVar *var;
+
+  return (var = scanner_var_update(id, TRUE, NULL))? var->version : 0;
+}
+
 /* get value of a variable by name */
 value_t scanner_get_value ( GQuark id, gchar ftype, gboolean update,
     expr_cache_t *expr )
@@ -505,6 +755,19 @@ value_t scanner_get_value ( GQuark id, gchar ftype, gboolean update,
   if(var->type == G_TOKEN_SET)
     expr_dep_add(id, expr);
 
+  /* the expression polls the variable's version rather than being marked
+   * volatile. Set variables only need polling if their own expression is
+   * polled, otherwise the dependency triggers cover them. Previous values,
+   * counts and times change without the value changing */
+  if(expr && (ftype == SCANNER_TYPE_STR || ftype == SCANNER_TYPE_VAL ||
+        ftype == SCANNER_TYPE_NONE))
+  {
+    if(var->type != G_TOKEN_SET || expr_cache_is_polled(var->expr))
+      expr_source_add(expr, id, var->version);
+  }
+  else if(expr)
+    expr->vstate = TRUE;
+
   if(ftype == SCANNER_TYPE_STR)
   {
     result.type = EXPR_TYPE_STRING;
@@ -8,12 +8,17 @@
 enum {
   SO_FILE = 0,
   SO_EXEC = 1,
-  SO_CLIENT = 2
+  SO_CLIENT = 2,
+  SO_PROCSTAT = 3,
+  SO_MEMINFO = 4,
+  SO_NETDEV = 5,
+  SO_DISKSTATS = 6
 };
 
 enum {
   VF_CHTIME = 1,
-  VF_NOGLOB = 2
+  VF_NOGLOB = 2,
+  VF_POPULATE = 4
 };
 
 enum {
@@ -41,6 +46,8 @@ typedef struct scan_file {
   time_t mtime;
   GList *vars;
   void *client;
+  gchar *prefix;
+  GHashTable *native;
 } ScanFile;
 
 typedef struct scan_var {
@@ -54,6 +61,9 @@ typedef struct scan_var {
   gint64 time;
   gint64 ptime;
   gint count;
+  guint version;
+  gboolean changed;
+  double vval;
   gint multi;
   guint type;
   gboolean invalid;
@@ -74,7 +84,9 @@ void scanner_file_merge ( ScanFile *keep, ScanFile *temp );
 GQuark scanner_parse_identifier ( const gchar *id, guint8 *dtype );
 ScanFile *scanner_file_get ( gchar *trigger );
 ScanFile *scanner_file_new ( gint , gchar *, gchar *, gint );
+ScanFile *scanner_file_native_new ( gint source, gchar *prefix );
 gboolean scanner_is_variable ( gchar *identifier );
+guint scanner_var_version ( GQuark id );
 void scanner_file_attach ( const gchar *trigger, ScanFile *file );
 
 #endif
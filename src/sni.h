@@ -56,6 +56,7 @@ typedef struct sni_item {
   gboolean menu;
   gint ref;
   guint signal;
+  guint refresh;
   guint32 order;
   GCancellable *cancel;
   GtkWidget *menu_obj;
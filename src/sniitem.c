@@ -12,8 +12,15 @@ struct sni_prop_wrapper {
   sni_item_t *sni;
 };
 
+/* preferred pixmap size, large enough to downscale to a hidpi tray icon */
+#define SNI_PIXMAP_SIZE 64
+#define SNI_REFRESH_DELAY 50
+/* number of unreferenced frames kept around for animated icons */
+#define SNI_PIXMAP_IDLE 16
+
 static GList *sni_items;
-static guint pix_counter;
+static GHashTable *sni_pixmaps;
+static GQueue sni_pixmaps_idle = G_QUEUE_INIT;
 static GList *sni_listeners;
 
 static gchar *sni_properties[] = { "Category", "Id", "Title", "Status",
@@ -90,46 +97,130 @@ gchar *sni_item_tooltip ( sni_item_t *item )
   return NULL;
 }
 
+static void sni_item_pixmap_release ( gchar *name )
+{
+  guint count;
+
+  if(!name || !sni_pixmaps)
+    return;
+
+  count = GPOINTER_TO_UINT(g_hash_table_lookup(sni_pixmaps, name));
+  if(!count)
+    return;
+  g_hash_table_insert(sni_pixmaps, g_strdup(name), GUINT_TO_POINTER(count-1));
+  if(count > 1)
+    return;
+
+  /* keep the last few unused frames, an animation will come back to them */
+  g_queue_push_head(&sni_pixmaps_idle, g_strdup(name));
+  if(sni_pixmaps_idle.length <= SNI_PIXMAP_IDLE)
+    return;
+  name = g_queue_pop_tail(&sni_pixmaps_idle);
+  g_hash_table_remove(sni_pixmaps, name);
+  scale_image_cache_remove(name);
+  g_free(name);
+}
+
+static guint64 sni_item_pixmap_hash ( const guchar *data, gsize len )
+{
+  guint64 hash = 0xcbf29ce484222325;
+  gsize i;
+
+  for(i=0; i<len; i++)
+    hash = (hash ^ data[i]) * 0x100000001b3;
+
+  return hash;
+}
+
+/* pick the smallest pixmap at least SNI_PIXMAP_SIZE wide, or the largest one
+ * if none are */
+static GVariant *sni_item_pixmap_select ( GVariant *v )
+{
+  GVariant *child, *best = NULL;
+  gint32 x, y, bx = 0;
+  gsize i;
+
+  for(i=0; i<g_variant_n_children(v); i++)
+  {
+    child = g_variant_get_child_value(v, i);
+    g_variant_get(child, "(ii@ay)", &x, &y, NULL);
+    if(x>0 && y>0 && (!best || (bx < SNI_PIXMAP_SIZE && x > bx) ||
+          (x >= SNI_PIXMAP_SIZE && x < bx)))
+    {
+      if(best)
+        g_variant_unref(best);
+      best = g_variant_ref(child);
+      bx = x;
+    }
+    g_variant_unref(child);
+  }
+
+  return best;
+}
+
 static gchar *sni_item_get_pixbuf ( GVariant *v )
 {
   GVariant *img,*child;
   cairo_surface_t *cs;
   GdkPixbuf *res;
   gint32 x,y;
-  guint32 *ptr;
+  const guint32 *src;
+  guint32 *dest;
   gsize len, i;
+  GList *idle;
   gchar *name;
+  gpointer count;
 
   if(!v || !g_variant_check_format_string(v, "a(iiay)", FALSE) ||
       g_variant_n_children(v) < 1)
     return NULL;
 
-  child = g_variant_get_child_value(v, 0);
+  if( !(child = sni_item_pixmap_select(v)) )
+    return NULL;
 
   g_variant_get(child, "(ii@ay)", &x, &y, &img);
-  ptr = (guint32 *)g_variant_get_fixed_array(img, &len, sizeof(guchar));
+  g_variant_unref(child);
+  src = g_variant_get_fixed_array(img, &len, sizeof(guchar));
 
-  if(!len || !ptr || len != x*y*4)
+  if(!len || !src || len != x*y*4)
   {
     g_variant_unref(img);
-    g_variant_unref(child);
     return NULL;
   }
 
-  ptr = g_memdup2(ptr, len);
-  g_variant_unref(img);
-  g_variant_unref(child);
+  /* animated icons cycle through the same few frames, reuse cached ones */
+  name = g_strdup_printf("<pixbufcache/>sni-%016" G_GINT64_MODIFIER "x-%dx%d",
+      sni_item_pixmap_hash((const guchar *)src, len), x, y);
+  if(!sni_pixmaps)
+    sni_pixmaps = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, NULL);
+  if(g_hash_table_lookup_extended(sni_pixmaps, name, NULL, &count))
+  {
+    if(!count && (idle = g_queue_find_custom(&sni_pixmaps_idle, name,
+            (GCompareFunc)g_strcmp0)))
+    {
+      g_free(idle->data);
+      g_queue_delete_link(&sni_pixmaps_idle, idle);
+    }
+    g_hash_table_insert(sni_pixmaps, g_strdup(name),
+        GUINT_TO_POINTER(GPOINTER_TO_UINT(count)+1));
+    g_variant_unref(img);
+    return name;
+  }
+
+  /* a plain loop of byte swaps gets vectorized by the compiler */
+  cs = cairo_image_surface_create(CAIRO_FORMAT_ARGB32, x, y);
+  cairo_surface_flush(cs);
+  dest = (guint32 *)cairo_image_surface_get_data(cs);
   for(i=0; i<x*y; i++)
-    ptr[i] = g_ntohl(ptr[i]);
+    dest[i] = GUINT32_FROM_BE(src[i]);
+  cairo_surface_mark_dirty(cs);
+  g_variant_unref(img);
 
-  cs = cairo_image_surface_create_for_data((guchar *)ptr, CAIRO_FORMAT_ARGB32,
-      x, y, cairo_format_stride_for_width(CAIRO_FORMAT_ARGB32, x));
   res = gdk_pixbuf_get_from_surface(cs, 0, 0, x, y);
   cairo_surface_destroy(cs);
-  g_free(ptr);
 
-  name = g_strdup_printf("<pixbufcache/>sni-%u", pix_counter++);
   scale_image_cache_insert(name, res);
+  g_hash_table_insert(sni_pixmaps, g_strdup(name), GUINT_TO_POINTER(1));
 
   return name;
 }
@@ -149,72 +240,99 @@ gchar *sni_item_get_tooltip ( GVariant *v )
     return NULL;
 }
 
-void sni_item_prop_cb ( GDBusConnection *con, GAsyncResult *res,
-    struct sni_prop_wrapper *wrap)
+static gboolean sni_item_string_set ( gchar **dest, gchar *str )
 {
-  GVariant *result, *inner;
-
-  wrap->sni->ref--;
-
-  if( (result = g_dbus_connection_call_finish(con, res, NULL)) )
+  if(!g_strcmp0(*dest, str))
   {
-    g_variant_get(result, "(v)", &inner);
-    g_variant_unref(result);
+    g_free(str);
+    return FALSE;
   }
+  g_free(*dest);
+  *dest = str;
+  return TRUE;
+}
 
-  if(!result || !inner)
-  {
-    g_free(wrap);
-    return;
-  }
+static gboolean sni_item_prop_set ( sni_item_t *sni, guint prop,
+    GVariant *inner )
+{
+  gboolean changed = FALSE;
+  gchar *name;
 
-  if(wrap->prop<=SNI_PROP_THEME &&
+  if(prop<=SNI_PROP_THEME &&
       g_variant_is_of_type(inner,G_VARIANT_TYPE_STRING))
   {
-    g_free(wrap->sni->string[wrap->prop]);
-    g_variant_get(inner, "s", &(wrap->sni->string[wrap->prop]));
-    g_debug("sni %s: property %s = %s", wrap->sni->dest,
-        sni_properties[wrap->prop], wrap->sni->string[wrap->prop]);
+    changed = sni_item_string_set(&sni->string[prop],
+        g_variant_dup_string(inner, NULL));
+    g_debug("sni %s: property %s = %s", sni->dest,
+        sni_properties[prop], sni->string[prop]);
   }
-  else if(wrap->prop>=SNI_PROP_ICONPIX && wrap->prop<=SNI_PROP_ATTNPIX)
+  else if(prop>=SNI_PROP_ICONPIX && prop<=SNI_PROP_ATTNPIX)
   {
-    scale_image_cache_remove(wrap->sni->string[wrap->prop]);
-    g_clear_pointer(&(wrap->sni->string[wrap->prop]), g_free);
-    wrap->sni->string[wrap->prop] = sni_item_get_pixbuf(inner);
-    g_debug("sni %s: property %s received", wrap->sni->dest,
-        sni_properties[wrap->prop]);
+    name = sni_item_get_pixbuf(inner);
+    sni_item_pixmap_release(sni->string[prop]);
+    changed = sni_item_string_set(&sni->string[prop], name);
+    g_debug("sni %s: property %s received", sni->dest,
+        sni_properties[prop]);
   }
-  else if(wrap->prop == SNI_PROP_MENU &&
+  else if(prop == SNI_PROP_MENU &&
       g_variant_is_of_type(inner,G_VARIANT_TYPE_OBJECT_PATH))
   {
-    g_free(wrap->sni->menu_path);
-    g_variant_get(inner, "o", &(wrap->sni->menu_path));
-    sni_menu_init(wrap->sni);
-    g_debug("sni %s: property %s = %s", wrap->sni->dest,
-        sni_properties[wrap->prop], wrap->sni->menu_path);
+    if(sni_item_string_set(&sni->menu_path,
+          g_variant_dup_string(inner, NULL)))
+      sni_menu_init(sni);
+    g_debug("sni %s: property %s = %s", sni->dest,
+        sni_properties[prop], sni->menu_path);
   }
-  else if(wrap->prop == SNI_PROP_ISMENU)
+  else if(prop == SNI_PROP_ISMENU &&
+      g_variant_is_of_type(inner, G_VARIANT_TYPE_BOOLEAN))
   {
-    g_variant_get(inner, "b", &(wrap->sni->menu));
-    g_debug("sni %s: property %s = %d", wrap->sni->dest,
-        sni_properties[wrap->prop], wrap->sni->menu);
+    changed = (sni->menu != g_variant_get_boolean(inner));
+    sni->menu = g_variant_get_boolean(inner);
+    g_debug("sni %s: property %s = %d", sni->dest,
+        sni_properties[prop], sni->menu);
   }
-  else if(wrap->prop == SNI_PROP_ORDER)
+  else if(prop == SNI_PROP_ORDER &&
+      g_variant_is_of_type(inner, G_VARIANT_TYPE_UINT32))
   {
-    g_variant_get(inner, "u", &(wrap->sni->order));
-    g_debug("sni %s: property %s = %u", wrap->sni->dest,
-        sni_properties[wrap->prop], wrap->sni->order);
+    changed = (sni->order != g_variant_get_uint32(inner));
+    sni->order = g_variant_get_uint32(inner);
+    g_debug("sni %s: property %s = %u", sni->dest,
+        sni_properties[prop], sni->order);
   }
-  else if(wrap->prop == SNI_PROP_TOOLTIP)
+  else if(prop == SNI_PROP_TOOLTIP &&
+      g_variant_check_format_string(inner, "(sa(iiay)ss)", FALSE))
   {
-    g_free(wrap->sni->tooltip);
-    wrap->sni->tooltip = sni_item_get_tooltip(inner);
-    g_debug("sni %s: property %s = %s", wrap->sni->dest,
-        sni_properties[wrap->prop], wrap->sni->tooltip);
+    changed = sni_item_string_set(&sni->tooltip,
+        sni_item_get_tooltip(inner));
+    g_debug("sni %s: property %s = %s", sni->dest,
+        sni_properties[prop], sni->tooltip);
   }
 
+  return changed;
+}
+
+void sni_item_prop_cb ( GDBusConnection *con, GAsyncResult *res,
+    struct sni_prop_wrapper *wrap)
+{
+  GVariant *result, *inner;
+
+  wrap->sni->ref--;
+
+  if( (result = g_dbus_connection_call_finish(con, res, NULL)) )
+  {
+    g_variant_get(result, "(v)", &inner);
+    g_variant_unref(result);
+  }
+
+  if(!result || !inner)
+  {
+    g_free(wrap);
+    return;
+  }
+
+  if(sni_item_prop_set(wrap->sni, wrap->prop, inner))
+    LISTENER_CALL(sni_invalidate, wrap->sni);
   g_variant_unref(inner);
-  LISTENER_CALL(sni_invalidate, wrap->sni);
   g_free(wrap);
 }
 
@@ -235,38 +353,72 @@ void sni_item_get_prop ( GDBusConnection *con, sni_item_t *sni,
     (GAsyncReadyCallback)sni_item_prop_cb, wrap);
 }
 
-void sni_item_signal_cb (GDBusConnection *con, const gchar *sender,
-         const gchar *path, const gchar *interface, const gchar *signal,
-         GVariant *parameters, gpointer data)
+static void sni_item_get_all_cb ( GDBusConnection *con, GAsyncResult *res,
+    sni_item_t *sni )
 {
-  g_debug("sni: received signal %s from %s", signal, sender);
-  if(!g_strcmp0(signal, "NewTitle"))
-    sni_item_get_prop(con, data,  SNI_PROP_TITLE);
-  else if(!g_strcmp0(signal, "NewStatus"))
-    sni_item_get_prop(con, data, SNI_PROP_STATUS);
-  else if(!g_strcmp0(signal, "NewToolTip"))
-    sni_item_get_prop(con, data, SNI_PROP_TOOLTIP);
-  else if(!g_strcmp0(signal, "NewIconThemePath"))
-    sni_item_get_prop(con, data, SNI_PROP_THEME);
-  else if(!g_strcmp0(signal, "NewIcon"))
-  {
-    sni_item_get_prop(con, data, SNI_PROP_ICON);
-    sni_item_get_prop(con, data, SNI_PROP_ICONACC);
-    sni_item_get_prop(con, data, SNI_PROP_ICONPIX);
-  }
-  else if(!g_strcmp0(signal, "NewOverlayIcon"))
+  GVariant *result, *dict, *value;
+  GVariantIter iter;
+  GError *error = NULL;
+  gboolean changed = FALSE;
+  gchar *name;
+  guint i;
+
+  if( !(result = g_dbus_connection_call_finish(con, res, &error)) )
   {
-    sni_item_get_prop(con, data, SNI_PROP_OVLAY);
-    sni_item_get_prop(con, data, SNI_PROP_OVLAYPIX);
+    /* the item is gone if the call was cancelled, otherwise fall back onto
+     * fetching properties one by one */
+    if(!g_error_matches(error, G_IO_ERROR, G_IO_ERROR_CANCELLED))
+      for(i=0; i<SNI_PROP_MAX; i++)
+        sni_item_get_prop(con, sni, i);
+    g_error_free(error);
+    return;
   }
-  else if(!g_strcmp0(signal, "NewAttentionIcon"))
+
+  g_variant_get(result, "(@a{sv})", &dict);
+  g_variant_iter_init(&iter, dict);
+  while(g_variant_iter_next(&iter, "{&sv}", &name, &value))
   {
-    sni_item_get_prop(con, data, SNI_PROP_ATTN);
-    sni_item_get_prop(con, data, SNI_PROP_ATTNACC);
-    sni_item_get_prop(con, data, SNI_PROP_ATTNPIX);
+    for(i=0; i<SNI_PROP_MAX; i++)
+      if(!g_strcmp0(name, sni_properties[i]))
+      {
+        changed |= sni_item_prop_set(sni, i, value);
+        break;
+      }
+    g_variant_unref(value);
   }
-  else if(!g_strcmp0(signal, "XAyatanaNewLabel"))
-    sni_item_get_prop(con, data, SNI_PROP_LABEL);
+  g_variant_unref(dict);
+  g_variant_unref(result);
+
+  if(changed)
+    LISTENER_CALL(sni_invalidate, sni);
+}
+
+static gboolean sni_item_refresh ( sni_item_t *sni )
+{
+  sni->refresh = 0;
+  g_dbus_connection_call(sni_get_connection(), sni->dest, sni->path,
+    "org.freedesktop.DBus.Properties", "GetAll",
+    g_variant_new("(s)", sni->iface), G_VARIANT_TYPE("(a{sv})"),
+    G_DBUS_CALL_FLAGS_NONE, -1, sni->cancel,
+    (GAsyncReadyCallback)sni_item_get_all_cb, sni);
+
+  return G_SOURCE_REMOVE;
+}
+
+/* coalesce bursts of change signals into a single GetAll */
+void sni_item_signal_cb (GDBusConnection *con, const gchar *sender,
+         const gchar *path, const gchar *interface, const gchar *signal,
+         GVariant *parameters, gpointer data)
+{
+  sni_item_t *sni = data;
+
+  g_debug("sni: received signal %s from %s", signal, sender);
+  if(!g_str_has_prefix(signal, "New") && g_strcmp0(signal, "XAyatanaNewLabel"))
+    return;
+
+  if(!sni->refresh)
+    sni->refresh = g_timeout_add(SNI_REFRESH_DELAY,
+        (GSourceFunc)sni_item_refresh, sni);
 }
 
 sni_item_t *sni_item_new (GDBusConnection *con, gchar *iface,
@@ -274,7 +426,6 @@ sni_item_t *sni_item_new (GDBusConnection *con, gchar *iface,
 {
   sni_item_t *sni;
   gchar *path;
-  guint i;
 
   sni = g_malloc0(sizeof(sni_item_t));
   sni->uid = g_strdup(uid);
@@ -296,8 +447,7 @@ sni_item_t *sni_item_new (GDBusConnection *con, gchar *iface,
       sni->iface, NULL, sni->path, NULL, 0, sni_item_signal_cb, sni, NULL);
   sni_items = g_list_append(sni_items, sni);
   LISTENER_CALL(sni_new, sni);
-  for(i=0; i<SNI_PROP_MAX; i++)
-    sni_item_get_prop(con, sni, i);
+  sni_item_refresh(sni);
 
   return sni;
 }
@@ -307,11 +457,13 @@ void sni_item_free ( sni_item_t *sni )
   gint i;
 
   g_dbus_connection_signal_unsubscribe(sni_get_connection(), sni->signal);
+  if(sni->refresh)
+    g_source_remove(sni->refresh);
   LISTENER_CALL(sni_destroy, sni);
   g_cancellable_cancel(sni->cancel);
   g_object_unref(sni->cancel);
   for(i=0; i<3; i++)
-    scale_image_cache_remove(sni->string[SNI_PROP_ICONPIX+i]);
+    sni_item_pixmap_release(sni->string[SNI_PROP_ICONPIX+i]);
   for(i=0; i<SNI_MAX_STRING; i++)
     g_free(sni->string[i]);
 
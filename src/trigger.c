@@ -8,6 +8,13 @@
 #include "vm/vm.h"
 
 static GHashTable *trigger_list;
+static GHashTable *trigger_names;
+static GHashTable *trigger_rates;
+static GHashTable *trigger_pending;
+static GQueue trigger_queue = G_QUEUE_INIT;
+static gboolean trigger_scheduled;
+static GMutex trigger_mutex;
+static GMutex trigger_name_mutex;
 
 typedef struct _trigger {
   trigger_func_t func;
@@ -19,8 +26,17 @@ typedef struct _trigger_invocation {
   vm_store_t *store;
 } trigger_invocation_t;
 
+typedef struct _trigger_rate {
+  gint64 interval;
+  gint64 last;
+  trigger_invocation_t *pending;
+  guint timer;
+} trigger_rate_t;
+
 #define TRIGGER(x) ((trigger_t *)(x))
 
+/* trigger names are case insensitive, cache the interned lowercase name for
+ * each spelling we see, interned names map onto themselves */
 const gchar *trigger_name_intern  ( gchar *name )
 {
   gchar *lower;
@@ -29,9 +45,21 @@ const gchar *trigger_name_intern  ( gchar *name )
   if(!name)
     return NULL;
 
-  lower = g_ascii_strdown(name, -1);
-  trigger_name = g_intern_string(lower);
-  g_free(lower);
+  g_mutex_lock(&trigger_name_mutex);
+  if(!trigger_names)
+    trigger_names = g_hash_table_new_full(g_str_hash, g_str_equal, g_free,
+        NULL);
+  if( !(trigger_name = g_hash_table_lookup(trigger_names, name)) )
+  {
+    lower = g_ascii_strdown(name, -1);
+    trigger_name = g_intern_string(lower);
+    g_free(lower);
+    g_hash_table_insert(trigger_names, g_strdup(name), (gpointer)trigger_name);
+    if(g_strcmp0(name, trigger_name))
+      g_hash_table_insert(trigger_names, g_strdup(trigger_name),
+          (gpointer)trigger_name);
+  }
+  g_mutex_unlock(&trigger_name_mutex);
 
   return trigger_name;
 }
@@ -66,19 +94,21 @@ const gchar *trigger_add ( gchar *name, trigger_func_t func, void *data )
 void trigger_remove ( gchar *name, trigger_func_t func, void *data )
 {
   GList *list, *iter;
+  const gchar *trigger_name;
   gpointer ptr;
 
   if(!name || !func || !trigger_list)
     return;
 
-  list = g_hash_table_lookup(trigger_list, trigger_name_intern(name));
+  trigger_name = trigger_name_intern(name);
+  list = g_hash_table_lookup(trigger_list, trigger_name);
   for(iter=list; iter; iter=g_list_next(iter))
     if(TRIGGER(iter->data)->func==func && TRIGGER(iter->data)->data==data)
     {
       ptr = iter->data;
       list = g_list_remove(list, ptr);
       g_free(ptr);
-      g_hash_table_replace(trigger_list, name, list);
+      g_hash_table_replace(trigger_list, (gchar *)trigger_name, list);
       return;
     }
 }
@@ -100,9 +130,36 @@ void trigger_action_cb ( vm_closure_t *closure, vm_store_t *store )
   vm_store_free(new_store);
 }
 
-static gboolean trigger_emit_in_main_context ( trigger_invocation_t *inv )
+static void trigger_invocation_free ( trigger_invocation_t *inv )
+{
+  vm_store_free(inv->store);
+  g_free(inv);
+}
+
+static gboolean trigger_rate_cb ( trigger_rate_t *rate );
+
+static void trigger_invoke ( trigger_invocation_t *inv )
 {
+  trigger_rate_t *rate;
   GList *iter;
+  gint64 now;
+
+  /* hold back rate limited triggers, keeping only the latest emission */
+  if(trigger_rates && (rate = g_hash_table_lookup(trigger_rates, inv->trigger)))
+  {
+    now = g_get_monotonic_time();
+    if(now < rate->last + rate->interval)
+    {
+      if(rate->pending)
+        trigger_invocation_free(rate->pending);
+      rate->pending = inv;
+      if(!rate->timer)
+        rate->timer = g_timeout_add((rate->last + rate->interval - now)/1000
+            + 1, (GSourceFunc)trigger_rate_cb, rate);
+      return;
+    }
+    rate->last = now;
+  }
 
   g_debug("trigger: '%s' %p", inv->trigger, inv->store);
   if(trigger_list)
@@ -110,21 +167,91 @@ static gboolean trigger_emit_in_main_context ( trigger_invocation_t *inv )
         iter=iter->next)
       TRIGGER(iter->data)->func(TRIGGER(iter->data)->data, inv->store);
 
-  vm_store_free(inv->store);
-  g_free(inv);
+  trigger_invocation_free(inv);
+}
 
-  return FALSE;
+static gboolean trigger_rate_cb ( trigger_rate_t *rate )
+{
+  rate->timer = 0;
+  if(rate->pending)
+    trigger_invoke(g_steal_pointer(&rate->pending));
+
+  return G_SOURCE_REMOVE;
+}
+
+void trigger_set_rate_limit ( gchar *name, gint64 interval )
+{
+  trigger_rate_t *rate;
+  const gchar *trigger_name;
+
+  if( !(trigger_name = trigger_name_intern(name)) )
+    return;
+
+  if(!trigger_rates)
+    trigger_rates = g_hash_table_new(g_direct_hash, g_direct_equal);
+
+  if( !(rate = g_hash_table_lookup(trigger_rates, trigger_name)) )
+  {
+    if(interval <= 0)
+      return;
+    rate = g_malloc0(sizeof(trigger_rate_t));
+    g_hash_table_insert(trigger_rates, (gchar *)trigger_name, rate);
+  }
+  rate->interval = MAX(interval, 0) * 1000;
+}
+
+/* drain all emissions queued since the last main loop iteration */
+static gboolean trigger_dispatch ( gpointer data )
+{
+  GQueue queue;
+  trigger_invocation_t *inv;
+
+  g_mutex_lock(&trigger_mutex);
+  queue = trigger_queue;
+  g_queue_init(&trigger_queue);
+  if(trigger_pending)
+    g_hash_table_remove_all(trigger_pending);
+  trigger_scheduled = FALSE;
+  g_mutex_unlock(&trigger_mutex);
+
+  while( (inv = g_queue_pop_head(&queue)) )
+    trigger_invoke(inv);
+
+  return G_SOURCE_REMOVE;
 }
 
 void trigger_emit_with_data ( gchar *name, vm_store_t *store )
 {
   trigger_invocation_t *inv;
+  const gchar *trigger_name;
+
+  if( !(trigger_name = trigger_name_intern(name)) )
+    return;
+
+  g_mutex_lock(&trigger_mutex);
+  /* emissions without a payload are identical, queue each trigger once */
+  if(!store)
+  {
+    if(!trigger_pending)
+      trigger_pending = g_hash_table_new(g_direct_hash, g_direct_equal);
+    if(!g_hash_table_add(trigger_pending, (gchar *)trigger_name))
+    {
+      g_mutex_unlock(&trigger_mutex);
+      return;
+    }
+  }
 
   inv = g_malloc0(sizeof(trigger_invocation_t));
-  inv->trigger = trigger_name_intern(name);
+  inv->trigger = trigger_name;
   inv->store = vm_store_dup(store);
+  g_queue_push_tail(&trigger_queue, inv);
 
-  g_main_context_invoke(NULL, (GSourceFunc)trigger_emit_in_main_context, inv);
+  if(!trigger_scheduled)
+  {
+    trigger_scheduled = TRUE;
+    g_idle_add_full(G_PRIORITY_DEFAULT, trigger_dispatch, NULL, NULL);
+  }
+  g_mutex_unlock(&trigger_mutex);
 }
 
 void trigger_emit_with_string ( gchar *name, gchar *var, gchar *val )
@@ -13,5 +13,6 @@ const gchar *trigger_name_intern  ( gchar *name );
 void trigger_emit_with_data ( gchar *name, vm_store_t *store );
 void trigger_emit_with_string ( gchar *name, gchar *var, gchar *val );
 gboolean trigger_emit ( gchar *name );
+void trigger_set_rate_limit ( gchar *name, gint64 interval );
 
 #endif
@@ -0,0 +1,62 @@
+/* This entire file is licensed under GNU General Public License v3.0
+ *
+ * Copyright 2025- sfwbar maintainers
+ */
+
+#include <time.h>
+#include "util/profile.h"
+
+gboolean profile_enabled;
+static GHashTable *profile_table;
+
+static guint profile_hash ( profile_entry_t *entry )
+{
+  return g_str_hash(entry->name) ^ (guint)entry->type;
+}
+
+static gboolean profile_equal ( profile_entry_t *e1, profile_entry_t *e2 )
+{
+  return e1->type == e2->type && !g_strcmp0(e1->name, e2->name);
+}
+
+gint64 profile_now ( void )
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (gint64)ts.tv_sec*1000000000 + ts.tv_nsec;
+}
+
+/* entries are keyed by the listener method and the type of the listener's
+ * data, so all taskbars (or pagers) are accounted together */
+void profile_record ( const gchar *name, GType type, gint64 time )
+{
+  profile_entry_t key, *entry;
+
+  if(!profile_table)
+    profile_table = g_hash_table_new_full((GHashFunc)profile_hash,
+        (GEqualFunc)profile_equal, g_free, NULL);
+
+  key.name = name;
+  key.type = type;
+  if( !(entry = g_hash_table_lookup(profile_table, &key)) )
+  {
+    entry = g_memdup2(&key, sizeof(profile_entry_t));
+    entry->calls = 0;
+    entry->time = 0;
+    g_hash_table_add(profile_table, entry);
+  }
+  entry->calls++;
+  entry->time += time;
+}
+
+GList *profile_get ( void )
+{
+  return profile_table? g_hash_table_get_keys(profile_table) : NULL;
+}
+
+void profile_reset ( void )
+{
+  if(profile_table)
+    g_hash_table_remove_all(profile_table);
+}
@@ -0,0 +1,35 @@
+#ifndef __SFWBAR_PROFILE_H__
+#define __SFWBAR_PROFILE_H__
+
+#include <glib-object.h>
+
+/* listener call timing, only collected while profile_enabled is set. The
+ * type of the listener's data is taken before the call, as the call may
+ * destroy it */
+typedef struct {
+  const gchar *name;
+  GType type;
+  guint64 calls;
+  gint64 time; /* ns */
+} profile_entry_t;
+
+extern gboolean profile_enabled;
+
+gint64 profile_now ( void );
+void profile_record ( const gchar *name, GType type, gint64 time );
+GList *profile_get ( void );
+void profile_reset ( void );
+
+#define PROFILE_CALL(name, data, call) { \
+  if(G_UNLIKELY(profile_enabled)) \
+  { \
+    GType _type = G_IS_OBJECT(data)? G_OBJECT_TYPE(data) : G_TYPE_NONE; \
+    gint64 _start = profile_now(); \
+    call; \
+    profile_record(name, _type, profile_now() - _start); \
+  } \
+  else \
+    call; \
+}
+
+#endif
@@ -4,6 +4,17 @@
  */
 
 #include <glib.h>
+#include "util/string.h"
+
+typedef struct _regex_cache_entry {
+  gchar *pattern;
+  GRegex *regex;
+  GList *link;
+} regex_cache_entry_t;
+
+static GMutex regex_cache_mutex;
+static GHashTable *regex_cache;
+static GQueue regex_cache_lru = G_QUEUE_INIT;
 
 guint str_nhash ( gchar *str )
 {
@@ -111,6 +122,79 @@ gboolean pattern_match ( gchar **dict, gchar *string )
   return FALSE;
 }
 
+/* caller must hold regex_cache_mutex */
+static regex_cache_entry_t *regex_cache_lookup ( const gchar *pattern )
+{
+  regex_cache_entry_t *entry;
+
+  if(!regex_cache)
+    regex_cache = g_hash_table_new(g_str_hash, g_str_equal);
+
+  if( (entry = g_hash_table_lookup(regex_cache, pattern)) )
+  {
+    if(entry->link && entry->link != regex_cache_lru.head)
+    {
+      g_queue_unlink(&regex_cache_lru, entry->link);
+      g_queue_push_head_link(&regex_cache_lru, entry->link);
+    }
+    return entry;
+  }
+
+  entry = g_malloc0(sizeof(regex_cache_entry_t));
+  entry->pattern = g_strdup(pattern);
+  entry->regex = g_regex_new(pattern, G_REGEX_OPTIMIZE, 0, NULL);
+  g_hash_table_insert(regex_cache, entry->pattern, entry);
+  g_queue_push_head(&regex_cache_lru, entry);
+  entry->link = regex_cache_lru.head;
+
+  while(g_queue_get_length(&regex_cache_lru) > REGEX_CACHE_SIZE)
+  {
+    entry = g_queue_pop_tail(&regex_cache_lru);
+    g_hash_table_remove(regex_cache, entry->pattern);
+    if(entry->regex)
+      g_regex_unref(entry->regex);
+    g_free(entry->pattern);
+    g_free(entry);
+  }
+
+  return g_hash_table_lookup(regex_cache, pattern);
+}
+
+/* returns a new reference to a compiled regex, or NULL if invalid */
+GRegex *regex_cache_get ( const gchar *pattern )
+{
+  regex_cache_entry_t *entry;
+  GRegex *regex;
+
+  if(!pattern)
+    return NULL;
+
+  g_mutex_lock(&regex_cache_mutex);
+  entry = regex_cache_lookup(pattern);
+  regex = entry->regex? g_regex_ref(entry->regex) : NULL;
+  g_mutex_unlock(&regex_cache_mutex);
+
+  return regex;
+}
+
+/* keep a pattern compiled for the lifetime of the program */
+void regex_cache_pin ( const gchar *pattern )
+{
+  regex_cache_entry_t *entry;
+
+  if(!pattern)
+    return;
+
+  g_mutex_lock(&regex_cache_mutex);
+  entry = regex_cache_lookup(pattern);
+  if(entry->link)
+  {
+    g_queue_delete_link(&regex_cache_lru, entry->link);
+    entry->link = NULL;
+  }
+  g_mutex_unlock(&regex_cache_mutex);
+}
+
 void regex_list_add ( GList **list, gchar *pattern )
 {
   GList *iter;
@@ -120,7 +204,7 @@ void regex_list_add ( GList **list, gchar *pattern )
     if(!g_strcmp0(pattern, g_regex_get_pattern(iter->data)))
       return;
 
-  if( (regex = g_regex_new(pattern, 0, 0, NULL)) )
+  if( (regex = regex_cache_get(pattern)) )
     *list = g_list_prepend(*list, regex);
 }
 
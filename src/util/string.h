@@ -3,6 +3,8 @@
 
 #include <glib.h>
 
+#define REGEX_CACHE_SIZE 64
+
 guint str_nhash ( gchar *str );
 gboolean str_nequal ( gchar *str1, gchar *str2 );
 gchar *str_replace ( gchar *str, gchar *old, gchar *new );
@@ -13,5 +15,7 @@ gchar *numeric_to_string ( double num, gint dec );
 gboolean pattern_match ( gchar **dict, gchar *string );
 gboolean regex_match_list ( GList *dict, gchar *string );
 void regex_list_add ( GList **list, gchar *pattern );
+GRegex *regex_cache_get ( const gchar *pattern );
+void regex_cache_pin ( const gchar *pattern );
 
 #endif
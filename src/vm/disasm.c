@@ -0,0 +1,363 @@
+/* This entire file is licensed under GNU General Public License v3.0
+ *
+ * Copyright 2025- sfwbar maintainers
+ */
+
+#include <glib.h>
+#include "vm/vm.h"
+
+static const gchar *vm_op_names[] = {
+  [EXPR_OP_IMMEDIATE] = "IMMEDIATE",
+  [EXPR_OP_JZ] = "JZ",
+  [EXPR_OP_JMP] = "JMP",
+  [EXPR_OP_CACHED] = "CACHED",
+  [EXPR_OP_VARIABLE] = "VARIABLE",
+  [EXPR_OP_FUNCTION] = "FUNCTION",
+  [EXPR_OP_DISCARD] = "DISCARD",
+  [EXPR_OP_LOCAL] = "LOCAL",
+  [EXPR_OP_LOCAL_ASSIGN] = "LOCAL_ASSIGN",
+  [EXPR_OP_HEAP] = "HEAP",
+  [EXPR_OP_HEAP_ASSIGN] = "HEAP_ASSIGN",
+  [EXPR_OP_RETURN] = "RETURN",
+};
+
+/* length of the instruction at pos, or 0 if it's invalid or truncated */
+static gsize vm_op_len ( const guint8 *code, gsize pos, gsize len )
+{
+  const guint8 *nul;
+  gsize size;
+
+  switch(code[pos])
+  {
+    case EXPR_OP_IMMEDIATE:
+      if(pos+1<len && code[pos+1]==EXPR_TYPE_STRING)
+      {
+        if( !(nul = memchr(code+pos+2, 0, len-pos-2)) )
+          return 0;
+        size = nul - (code+pos) + 1;
+      }
+      else
+        size = sizeof(value_t)+1;
+      break;
+    case EXPR_OP_JZ:
+    case EXPR_OP_JMP:
+      size = sizeof(gint)+1;
+      break;
+    case EXPR_OP_CACHED:
+      size = 2;
+      break;
+    case EXPR_OP_VARIABLE:
+      size = sizeof(GQuark)+2;
+      break;
+    case EXPR_OP_FUNCTION:
+      size = sizeof(gpointer)+2;
+      break;
+    case EXPR_OP_LOCAL:
+    case EXPR_OP_LOCAL_ASSIGN:
+      size = sizeof(guint16)+1;
+      break;
+    case EXPR_OP_HEAP:
+    case EXPR_OP_HEAP_ASSIGN:
+      size = sizeof(GQuark)+1;
+      break;
+    case EXPR_OP_DISCARD:
+    case EXPR_OP_RETURN:
+    case '!':
+      size = 1;
+      break;
+    case '<':
+    case '>':
+      size = (pos+1<len && code[pos+1]=='=')? 2 : 1;
+      break;
+    default:
+      size = strchr("+-*/%=&|", code[pos])? 1 : 0;
+  }
+
+  return pos+size<=len? size : 0;
+}
+
+/* net effect of the instruction on the stack depth and the number of
+ * values it needs on the stack */
+static gint vm_op_stack ( const guint8 *code, gsize pos, gint *need )
+{
+  switch(code[pos])
+  {
+    case EXPR_OP_IMMEDIATE:
+    case EXPR_OP_VARIABLE:
+    case EXPR_OP_LOCAL:
+    case EXPR_OP_HEAP:
+      *need = 0;
+      return 1;
+    case EXPR_OP_FUNCTION:
+      *need = code[pos+1];
+      return 1-code[pos+1];
+    case EXPR_OP_JZ:
+    case EXPR_OP_DISCARD:
+    case EXPR_OP_LOCAL_ASSIGN:
+    case EXPR_OP_HEAP_ASSIGN:
+      *need = 1;
+      return -1;
+    case '!':
+      *need = 1;
+      return 0;
+    case EXPR_OP_JMP:
+    case EXPR_OP_CACHED:
+    case EXPR_OP_RETURN:
+      *need = 0;
+      return 0;
+    default:
+      *need = 2;
+      return -1;
+  }
+}
+
+static gsize vm_op_target ( const guint8 *code, gsize pos )
+{
+  gint jmp;
+
+  memcpy(&jmp, code+pos+1, sizeof(gint));
+  return pos+sizeof(gint)+1+jmp;
+}
+
+/* check that the code decodes into whole instructions, that jumps land on
+ * instruction boundaries and that the stack depth is consistent on every
+ * path. On success, max and end receive the peak and final stack depth */
+gboolean vm_code_verify ( GBytes *bytes, gint *max, gint *end, gchar **err )
+{
+  const guint8 *code;
+  gsize len, pos, size, target, succ[2], *work;
+  gint *depth, need, new, peak = 0, final = -1, nwork = 0, nsucc, i;
+  gboolean *boundary;
+
+  g_return_val_if_fail(bytes, FALSE);
+  code = g_bytes_get_data(bytes, &len);
+  *err = NULL;
+
+  boundary = g_malloc0(sizeof(gboolean)*(len+1));
+  depth = g_malloc(sizeof(gint)*(len+1));
+  work = g_malloc(sizeof(gsize)*(len+1));
+
+  for(pos=0; pos<len; pos+=size)
+  {
+    boundary[pos] = TRUE;
+    depth[pos] = -1;
+    if( !(size = vm_op_len(code, pos, len)) )
+    {
+      *err = g_strdup_printf("%04zx: invalid or truncated instruction %d",
+          pos, code[pos]);
+      goto out;
+    }
+  }
+  boundary[len] = TRUE;
+  depth[len] = -1;
+
+  depth[0] = 0;
+  work[nwork++] = 0;
+  while(nwork)
+  {
+    pos = work[--nwork];
+    if(pos==len || code[pos]==EXPR_OP_RETURN)
+    {
+      if(final>=0 && final!=depth[pos])
+      {
+        *err = g_strdup_printf("%04zx: exit with stack depth %d, expected %d",
+            pos, depth[pos], final);
+        goto out;
+      }
+      final = depth[pos];
+      continue;
+    }
+
+    new = depth[pos] + vm_op_stack(code, pos, &need);
+    if(depth[pos]<need)
+    {
+      *err = g_strdup_printf("%04zx: %s needs %d values, stack has %d", pos,
+          code[pos]<G_N_ELEMENTS(vm_op_names)? vm_op_names[code[pos]] : "op",
+          need, depth[pos]);
+      goto out;
+    }
+    peak = MAX(peak, new);
+
+    nsucc = 0;
+    if(code[pos]!=EXPR_OP_JMP)
+      succ[nsucc++] = pos + vm_op_len(code, pos, len);
+    if(code[pos]==EXPR_OP_JMP || code[pos]==EXPR_OP_JZ)
+      succ[nsucc++] = vm_op_target(code, pos);
+
+    for(i=0; i<nsucc; i++)
+    {
+      target = succ[i];
+      if(target>len || !boundary[target])
+      {
+        *err = g_strdup_printf("%04zx: jump to %04zx is out of bounds",
+            pos, target);
+        goto out;
+      }
+      if(depth[target]<0)
+      {
+        depth[target] = new;
+        work[nwork++] = target;
+      }
+      else if(depth[target]!=new)
+      {
+        *err = g_strdup_printf("%04zx: stack depth %d at %04zx, expected %d",
+            pos, new, target, depth[target]);
+        goto out;
+      }
+    }
+  }
+
+out:
+  if(max)
+    *max = peak;
+  if(end)
+    *end = MAX(final, 0);
+  g_free(boundary);
+  g_free(depth);
+  g_free(work);
+
+  return !*err;
+}
+
+static void vm_code_reads_add ( GArray *reads, GQuark quark )
+{
+  guint i;
+
+  for(i=0; i<reads->len; i++)
+    if(g_array_index(reads, GQuark, i) == quark)
+      return;
+  g_array_append_val(reads, quark);
+}
+
+static void vm_code_reads_walk ( GBytes *bytes, GArray *reads,
+    GHashTable *visited )
+{
+  const guint8 *code;
+  vm_function_t *func;
+  GQuark quark;
+  gsize len, pos, size;
+
+  code = g_bytes_get_data(bytes, &len);
+  for(pos=0; pos<len; pos+=size)
+  {
+    if( !(size = vm_op_len(code, pos, len)) )
+      return;
+    switch(code[pos])
+    {
+      case EXPR_OP_VARIABLE:
+        memcpy(&quark, code+pos+2, sizeof(GQuark));
+        vm_code_reads_add(reads, quark);
+        break;
+      case EXPR_OP_HEAP:
+        memcpy(&quark, code+pos+1, sizeof(GQuark));
+        vm_code_reads_add(reads, quark);
+        break;
+      case EXPR_OP_FUNCTION:
+        memcpy(&func, code+pos+2, sizeof(gpointer));
+        if(!func)
+          break;
+        vm_code_reads_add(reads, func->quark);
+        if((func->flags & VM_FUNC_USERDEFINED) && func->ptr.code &&
+            g_hash_table_add(visited, func))
+          vm_code_reads_walk(func->ptr.code, reads, visited);
+        break;
+    }
+  }
+}
+
+/* static read set of the code: every variable and function it may refer
+ * to on any path, including the bodies of user defined functions it calls.
+ * Returns a zero terminated array of quarks */
+GQuark *vm_code_reads ( GBytes *bytes )
+{
+  GHashTable *visited;
+  GArray *reads;
+
+  g_return_val_if_fail(bytes, NULL);
+
+  reads = g_array_new(TRUE, FALSE, sizeof(GQuark));
+  visited = g_hash_table_new(g_direct_hash, g_direct_equal);
+  vm_code_reads_walk(bytes, reads, visited);
+  g_hash_table_destroy(visited);
+
+  return (GQuark *)g_array_free(reads, FALSE);
+}
+
+gchar *vm_code_disasm ( GBytes *bytes )
+{
+  GString *str;
+  const guint8 *code;
+  vm_function_t *func;
+  value_t value;
+  GQuark quark;
+  guint16 pos16;
+  gsize len, pos, size;
+
+  g_return_val_if_fail(bytes, NULL);
+  code = g_bytes_get_data(bytes, &len);
+  str = g_string_new(NULL);
+
+  for(pos=0; pos<len; pos+=size)
+  {
+    if( !(size = vm_op_len(code, pos, len)) )
+    {
+      g_string_append_printf(str, "%04zx  ??? %d\n", pos, code[pos]);
+      break;
+    }
+    if(code[pos]<G_N_ELEMENTS(vm_op_names))
+      g_string_append_printf(str, "%04zx  %-13s", pos, vm_op_names[code[pos]]);
+    else
+      g_string_append_printf(str, "%04zx  %-13.*s", pos, (gint)size,
+          code+pos);
+
+    switch(code[pos])
+    {
+      case EXPR_OP_IMMEDIATE:
+        if(code[pos+1]==EXPR_TYPE_STRING)
+        {
+          g_string_append_c(str, '"');
+          g_string_append(str, (gchar *)code+pos+2);
+          g_string_append_c(str, '"');
+          break;
+        }
+        memcpy(&value, code+pos+1, sizeof(value_t));
+        if(value_is_numeric(value))
+          g_string_append_printf(str, "%g", value.value.numeric);
+        else
+          g_string_append(str, "n/a");
+        break;
+      case EXPR_OP_JZ:
+      case EXPR_OP_JMP:
+        g_string_append_printf(str, "-> %04zx", vm_op_target(code, pos));
+        break;
+      case EXPR_OP_CACHED:
+        g_string_append_printf(str, "%d", code[pos+1]);
+        break;
+      case EXPR_OP_VARIABLE:
+        memcpy(&quark, code+pos+2, sizeof(GQuark));
+        g_string_append_printf(str, "%s (ftype %d)", g_quark_to_string(quark),
+            code[pos+1]);
+        break;
+      case EXPR_OP_HEAP:
+      case EXPR_OP_HEAP_ASSIGN:
+        memcpy(&quark, code+pos+1, sizeof(GQuark));
+        g_string_append(str, g_quark_to_string(quark));
+        break;
+      case EXPR_OP_LOCAL:
+      case EXPR_OP_LOCAL_ASSIGN:
+        memcpy(&pos16, code+pos+1, sizeof(guint16));
+        g_string_append_printf(str, "%d", pos16);
+        break;
+      case EXPR_OP_FUNCTION:
+        memcpy(&func, code+pos+2, sizeof(gpointer));
+        g_string_append_printf(str, "%s/%d%s%s", func? func->name : "(null)",
+            code[pos+1],
+            func && (func->flags & VM_FUNC_USERDEFINED)? " user" : "",
+            func && (func->flags & VM_FUNC_MEMOIZE)? " memo" : "");
+        break;
+    }
+    g_string_append_c(str, '\n');
+  }
+
+  return g_string_free(str, FALSE);
+}
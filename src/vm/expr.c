@@ -8,16 +8,125 @@
 #include "vm/vm.h"
 #include "util/string.h"
 
+typedef struct {
+  GQuark quark;
+  guint version;
+} expr_source_t;
+
 static GData *expr_deps;
+static guint expr_reads_serial;
+
+static gboolean expr_cache_reads_has ( expr_cache_t *expr, GQuark quark )
+{
+  gint i;
+
+  for(i=0; expr->reads && expr->reads[i]; i++)
+    if(expr->reads[i] == quark)
+      return TRUE;
+  return FALSE;
+}
+
+/* register everything the code may read as a dependency up front, so
+ * branches that weren't taken on the last evaluation still trigger it.
+ * Old dependencies are dropped first, so the expression isn't in any of
+ * the lists and can be prepended without a lookup */
+static void expr_cache_reads_update ( expr_cache_t *expr )
+{
+  GList *list;
+  gint i;
+
+  if(expr->reads)
+    expr_dep_remove(expr);
+  g_free(expr->reads);
+  expr->reads = expr->code? vm_code_reads(expr->code) : NULL;
+  expr->reads_serial = expr_reads_serial;
+
+  for(i=0; expr->reads && expr->reads[i]; i++)
+  {
+    list = g_datalist_id_get_data(&expr_deps, expr->reads[i]);
+    g_datalist_id_set_data(&expr_deps, expr->reads[i],
+        g_list_prepend(list, expr));
+    if(expr->parent)
+      expr_dep_add(expr->reads[i], expr->parent);
+  }
+}
+
+/* read sets include the bodies of user defined functions, recompute them
+ * when a function is (re)defined */
+void expr_reads_invalidate ( void )
+{
+  expr_reads_serial++;
+}
+
+/* record the version of a scanner variable seen by the expression */
+void expr_source_add ( expr_cache_t *expr, GQuark quark, guint version )
+{
+  expr_source_t source, *iter;
+  guint i;
+
+  if(!expr)
+    return;
+  if(!expr->sources)
+    expr->sources = g_array_new(FALSE, FALSE, sizeof(expr_source_t));
+
+  for(i=0; i<expr->sources->len; i++)
+  {
+    iter = &g_array_index(expr->sources, expr_source_t, i);
+    if(iter->quark == quark)
+    {
+      iter->version = version;
+      return;
+    }
+  }
+  source.quark = quark;
+  source.version = version;
+  g_array_append_val(expr->sources, source);
+}
+
+gboolean expr_cache_is_polled ( expr_cache_t *expr )
+{
+  return expr && expr->sources && expr->sources->len;
+}
+
+/* whether the scheduler should keep visiting the expression: it's dirty,
+ * volatile or polls scanner variables for a new version */
+gboolean expr_cache_needs_poll ( expr_cache_t *expr )
+{
+  return expr && (expr->eval || expr_cache_is_polled(expr));
+}
+
+/* a polled expression only needs to run if a variable it read last time
+ * has moved on to a new version */
+static gboolean expr_sources_changed ( expr_cache_t *expr )
+{
+  expr_source_t *source;
+  guint i;
+
+  if(!expr->code || !expr->sources)
+    return FALSE;
+
+  for(i=0; i<expr->sources->len; i++)
+  {
+    source = &g_array_index(expr->sources, expr_source_t, i);
+    if(scanner_var_version(source->quark) != source->version)
+      return TRUE;
+  }
+
+  return FALSE;
+}
 
 gboolean expr_cache_eval ( expr_cache_t *expr )
 {
   value_t v1;
   gchar *eval;
 
-  if(!expr || !expr->eval)
+  if(!expr || (!expr->eval && !expr_sources_changed(expr)))
     return FALSE;
 
+  if(expr->reads_serial != expr_reads_serial)
+    expr_cache_reads_update(expr);
+  if(expr->sources)
+    g_array_set_size(expr->sources, 0);
   expr->vstate = FALSE;
   v1 = vm_expr_eval(expr);
   if(v1.type==EXPR_TYPE_STRING)
@@ -58,10 +167,24 @@ expr_cache_t *expr_cache_new_with_code ( GBytes *code )
   expr = expr_cache_new();
   expr->code = code;
   expr->eval = TRUE;
+  expr_cache_reads_update(expr);
 
   return expr;
 }
 
+void expr_cache_set_code ( expr_cache_t *expr, GBytes *code )
+{
+  GBytes *old;
+
+  g_return_if_fail(expr);
+
+  old = expr->code;
+  expr->code = code? g_bytes_ref(code) : NULL;
+  g_bytes_unref(old);
+  expr->eval = !!code;
+  expr_cache_reads_update(expr);
+}
+
 void expr_cache_free ( expr_cache_t *expr )
 {
   if(!expr)
@@ -69,6 +192,9 @@ void expr_cache_free ( expr_cache_t *expr )
   expr_dep_remove(expr);
   g_free(expr->definition);
   g_free(expr->cache);
+  g_free(expr->reads);
+  if(expr->sources)
+    g_array_free(expr->sources, TRUE);
   g_bytes_unref(expr->code);
   g_free(expr);
 }
@@ -81,8 +207,13 @@ void expr_dep_add ( GQuark quark, expr_cache_t *expr )
   if(!expr)
     return;
 
+  /* quarks in the static read set are already registered for expr */
+  iter = expr_cache_reads_has(expr, quark)? expr->parent : expr;
+  if(!iter)
+    return;
+
   list = g_datalist_id_get_data(&expr_deps, quark);
-  for(iter=expr; iter; iter=iter->parent)
+  for(; iter; iter=iter->parent)
     if(!g_list_find(list, iter))
       list = g_list_prepend(list, iter);
   g_datalist_id_set_data(&expr_deps, quark, list);
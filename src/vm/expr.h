@@ -14,17 +14,25 @@ typedef struct expr_cache {
   guint vstate;
   struct expr_cache *parent;
   void *store;
+  GQuark *reads;
+  guint reads_serial;
+  GArray *sources;
 } expr_cache_t;
 
 gboolean expr_cache_eval ( expr_cache_t *expr );
 void expr_lib_init ( void );
 expr_cache_t *expr_cache_new ( void );
 expr_cache_t *expr_cache_new_with_code ( GBytes *code );
+void expr_cache_set_code ( expr_cache_t *expr, GBytes *code );
 void expr_cache_set ( expr_cache_t *expr, gchar *def );
 void expr_cache_free ( expr_cache_t *expr );
+gboolean expr_cache_is_polled ( expr_cache_t *expr );
+gboolean expr_cache_needs_poll ( expr_cache_t *expr );
+void expr_source_add ( expr_cache_t *expr, GQuark quark, guint version );
 void expr_dep_add ( GQuark quark, expr_cache_t *expr );
 void expr_dep_remove ( expr_cache_t *expr );
 void expr_dep_trigger ( GQuark quark );
 void expr_dep_dump ( void );
+void expr_reads_invalidate ( void );
 
 #endif
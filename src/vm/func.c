@@ -25,20 +25,25 @@ vm_function_t *vm_func_lookup ( gchar *name )
 
   func = g_malloc0(sizeof(vm_function_t));
   func->name = g_strdup(name);
+  func->quark = g_quark_from_string(name);
   g_hash_table_insert(vm_func_table, func->name, func);
 
   return func;
 }
 
-void vm_func_add ( gchar *name, vm_func_t function, gboolean deterministic )
+/* flags: TRUE/VM_FUNC_DETERMINISTIC if the function doesn't need to be
+ * polled, add VM_FUNC_MEMOIZE if the result depends only on parameters */
+void vm_func_add ( gchar *name, vm_func_t function, guint8 flags )
 {
   vm_function_t *func;
 
   func = vm_func_lookup(name);
 
   func->ptr.function = function;
-  func->flags |= (deterministic? VM_FUNC_DETERMINISTIC : 0);
-  expr_dep_trigger(g_quark_from_string(name));
+  func->flags |= flags & (VM_FUNC_DETERMINISTIC | VM_FUNC_MEMOIZE);
+  if(func->flags & VM_FUNC_MEMOIZE)
+    func->flags |= VM_FUNC_DETERMINISTIC;
+  expr_dep_trigger(func->quark);
   g_debug("function: registered '%s'", name);
 }
 
@@ -49,7 +54,8 @@ void vm_func_add_user ( gchar *name, GBytes *code )
   func = vm_func_lookup(name);
   func->ptr.code = code;
   func->flags = VM_FUNC_USERDEFINED;
-  expr_dep_trigger(g_quark_from_string(name));
+  expr_reads_invalidate();
+  expr_dep_trigger(func->quark);
   g_debug("function: registered '%s'", name);
 }
 
@@ -61,4 +67,5 @@ void vm_func_remove ( gchar *name )
     return;
 
   func->ptr.function = NULL;
+  func->flags &= ~VM_FUNC_MEMOIZE;
 }
@@ -91,6 +91,20 @@ static void parser_emit_function ( GByteArray *code, const void *f, guint8 np )
   g_byte_array_append(code, data, sizeof(gpointer)+2);
 }
 
+/* pin a constant regex pattern parameter in the regex cache, so runtime
+ * lookups never recompile it */
+static void parser_regex_bind ( GByteArray *code, guint start )
+{
+  gchar *pattern;
+
+  if(code->len < start+3 || code->data[start] != EXPR_OP_IMMEDIATE ||
+      code->data[start+1] != EXPR_TYPE_STRING)
+    return;
+  pattern = (gchar *)code->data + start + 2;
+  if(start + 2 + strlen(pattern) + 1 == code->len)
+    regex_cache_pin(pattern);
+}
+
 static void parser_jump_backpatch ( GByteArray *code, gint olen, gint clen )
 {
   gint data = clen - olen - sizeof(gint);
@@ -185,10 +199,13 @@ static gboolean parser_if ( GScanner *scanner, GByteArray *code )
 static gboolean parser_function ( GScanner *scanner, GByteArray *code )
 {
   gconstpointer ptr;
+  gboolean regex;
+  guint start;
   guint8 np;
 
   if(!g_ascii_strcasecmp(scanner->value.v_identifier, "ident"))
     scanner->config->identifier_2_string = TRUE;
+  regex = !g_ascii_strcasecmp(scanner->value.v_identifier, "extract");
 
   ptr = vm_func_lookup(scanner->value.v_identifier);
   g_scanner_get_next_token(scanner); // consume '('
@@ -197,8 +214,11 @@ static gboolean parser_function ( GScanner *scanner, GByteArray *code )
   if(g_scanner_peek_next_token(scanner)!=')')
     do
     {
+      start = code->len;
       if(!parser_expr_parse(scanner, code))
         return FALSE;
+      if(regex && np==1)
+        parser_regex_bind(code, start);
       np++;
     } while(g_scanner_get_next_token(scanner)==',' && np<255);
   else
@@ -723,6 +743,32 @@ gboolean parser_function_parse( GScanner *scanner )
   return !scanner->max_parse_errors;
 }
 
+/* compile a standalone expression, outside of a config file */
+GBytes *parser_expr_compile ( gchar *expr )
+{
+  GScanner *scanner;
+  GByteArray *code;
+  vm_store_t *store;
+  gboolean result;
+
+  if(!expr)
+    return NULL;
+
+  store = vm_store_new(NULL, FALSE);
+  scanner = config_scanner_new("expression", expr, store);
+  code = g_byte_array_new();
+  result = parser_expr_parse(scanner, code) && !scanner->max_parse_errors &&
+    g_scanner_peek_next_token(scanner) == G_TOKEN_EOF;
+  config_scanner_free(scanner);
+  vm_store_free(store);
+
+  if(result)
+    return g_byte_array_free_to_bytes(code);
+
+  g_byte_array_unref(code);
+  return NULL;
+}
+
 GBytes *parser_exec_build ( gchar *cmd )
 {
   GByteArray *code;
@@ -5,54 +5,88 @@ void value_free ( value_t v1 )
 {
   if(value_is_string(v1))
     g_free(v1.value.string);
-  else if(value_is_array(v1))
-    g_array_unref(v1.value.array);
+  else if(value_is_array(v1) &&
+      g_atomic_ref_count_dec(&v1.value.array->refcount))
+  {
+    g_array_unref(v1.value.array->data);
+    g_free(v1.value.array);
+  }
+}
+
+/* takes ownership of the GArray */
+value_t value_new_array ( GArray *array )
+{
+  value_array_t *shared;
+
+  shared = g_malloc(sizeof(value_array_t));
+  g_atomic_ref_count_init(&shared->refcount);
+  shared->data = array;
+
+  return ((value_t){.type=EXPR_TYPE_ARRAY, .value.array=shared});
+}
+
+/* return array storage that can be modified in place, cloning it first if
+ * it's shared with other values. Elements are duplicated shallowly, nested
+ * arrays remain shared */
+GArray *value_array_writable ( value_t *v1 )
+{
+  GArray *array;
+  value_t v2;
+  gsize i;
+
+  g_return_val_if_fail(v1 && value_is_array(*v1), NULL);
+
+  if(g_atomic_ref_count_compare(&v1->value.array->refcount, 1))
+    return v1->value.array->data;
+
+  array = g_array_sized_new(FALSE, FALSE, sizeof(value_t),
+      v1->value.array->data->len);
+  g_array_set_clear_func(array, (GDestroyNotify)value_free);
+
+  for(i=0; i<v1->value.array->data->len; i++)
+  {
+    v2 = value_dup(g_array_index(v1->value.array->data, value_t, i));
+    g_array_append_val(array, v2);
+  }
+  value_free(*v1);
+  *v1 = value_new_array(array);
+
+  return array;
 }
 
 value_t value_array_concat ( value_t v1, value_t v2 )
 {
-  GArray *result;
-  value_t new;
-  gpointer data;
-  gsize len;
+  value_t result, new;
+  GArray *array;
+  gsize i;
 
-  if(!value_is_array(v1) && !value_is_array(v1))
+  if(!value_is_array(v1) && !value_is_array(v2))
     return value_na;
 
   if(!value_is_array(v1))
   {
+    result = value_dup(v2);
     new = value_dup(v1);
-    result = g_array_prepend_vals(g_array_ref(v2.value.array), &new, 1);
+    g_array_prepend_vals(value_array_writable(&result), &new, 1);
   }
   else if(!value_is_array(v2))
   {
+    result = value_dup(v1);
     new = value_dup(v2);
-    result = g_array_append_vals(g_array_ref(v1.value.array), &new, 1);
+    g_array_append_vals(value_array_writable(&result), &new, 1);
   }
   else
   {
-    data = g_array_steal(v2.value.array, &len);
-    result = g_array_append_vals(g_array_ref(v1.value.array), data, len);
+    result = value_dup(v1);
+    array = value_array_writable(&result);
+    for(i=0; i<v2.value.array->data->len; i++)
+    {
+      new = value_dup(g_array_index(v2.value.array->data, value_t, i));
+      g_array_append_val(array, new);
+    }
   }
 
-  return value_new_array(result);
-}
-
-value_t value_dup_array ( value_t v1 )
-{
-  GArray *array;
-  value_t v2;
-  gsize i;
-
-  array = g_array_sized_new(FALSE, FALSE, sizeof(value_t), v1.value.array->len);
-  g_array_set_clear_func(array, (GDestroyNotify)value_free);
-
-  for(i=0; i<v1.value.array->len;i++)
-  {
-    v2 = value_dup(g_array_index(v1.value.array, value_t, i));
-    g_array_append_val(array, v2);
-  }
-  return value_new_array(array);
+  return result;
 }
 
 value_t value_dup ( value_t v1 )
@@ -60,6 +94,6 @@ value_t value_dup ( value_t v1 )
   if(value_is_string(v1))
     return value_new_string(g_strdup(v1.value.string));
   if(value_is_array(v1))
-    return value_dup_array(v1);
+    g_atomic_ref_count_inc(&v1.value.array->refcount);
   return v1;
 }
@@ -11,13 +11,19 @@ enum expr_type_t {
   EXPR_TYPE_NA
 };
 
+/* arrays are shared between values and copied on write */
+typedef struct {
+  gatomicrefcount refcount;
+  GArray *data;
+} value_array_t;
+
 typedef struct {
   guint8 type;
   union {
     gboolean boolean;
     gdouble numeric;
     gchar *string;
-    GArray *array;
+    value_array_t *array;
   } value;
 } value_t;
 
@@ -27,8 +33,6 @@ extern const value_t value_na;
   ((value_t){.type=EXPR_TYPE_STRING, .value.string=(v)})
 #define value_new_numeric(v) \
   ((value_t){.type=EXPR_TYPE_NUMERIC, .value.numeric=(v)})
-#define value_new_array(v) \
-  ((value_t){.type=EXPR_TYPE_ARRAY, .value.array=(v)})
 #define value_new_na() (value_na)
 
 #define value_is_string(v) ((v).type == EXPR_TYPE_STRING)
@@ -43,13 +47,15 @@ extern const value_t value_na;
 #define value_get_string(v) \
   ((value_is_string(v)&&v.value.string)?v.value.string:"")
 #define value_get_numeric(v) (value_is_numeric(v)?v.value.numeric:0)
-#define value_get_array(v) (value_is_array(v)?v.value.array:NULL)
+#define value_get_array(v) (value_is_array(v)?v.value.array->data:NULL)
 
 #define value_as_numeric(v) (value_like_numeric(v)? value_get_numeric(v) : \
     (value_is_string(v)? g_ascii_strtod(v.value.string, NULL) : 0))
 
 void value_free ( value_t );
 value_t value_dup ( value_t );
+value_t value_new_array ( GArray *array );
+GArray *value_array_writable ( value_t *v1 );
 value_t value_array_concat ( value_t v1, value_t v2 );
 
 #endif
@@ -128,9 +128,6 @@ value_t vm_function_call ( vm_t *vm, GBytes *code, guint8 np )
   vm->fp = vm->stack->len - np;
   v1 = vm_run(vm);
 
-  if(vm->expr)
-    vm->expr->vstate = TRUE;
-
   vm->code = saved_code;
   vm->ip = saved_ip;
   vm->len = saved_len;
@@ -140,8 +137,125 @@ value_t vm_function_call ( vm_t *vm, GBytes *code, guint8 np )
   return v1;
 }
 
+/* memoized results of pure builtins, keyed by call site and parameters.
+ * The table is flushed when it fills up */
+#define VM_MEMO_MAX 1024
+
+typedef struct {
+  guint8 *ip;
+  vm_function_t *func;
+  value_t *params;
+  guint8 np;
+  guint hash;
+  value_t result;
+} vm_memo_t;
+
+static GHashTable *vm_memo;
+static GMutex vm_memo_mutex;
+
+static guint vm_memo_hash ( vm_memo_t *memo )
+{
+  return memo->hash;
+}
+
+static gboolean vm_memo_equal ( vm_memo_t *m1, vm_memo_t *m2 )
+{
+  gint i;
+
+  if(m1->ip!=m2->ip || m1->func!=m2->func || m1->np!=m2->np)
+    return FALSE;
+
+  for(i=0; i<m1->np; i++)
+  {
+    if(m1->params[i].type != m2->params[i].type)
+      return FALSE;
+    if(value_is_string(m1->params[i]) && g_strcmp0(
+          m1->params[i].value.string, m2->params[i].value.string))
+      return FALSE;
+    if(value_is_numeric(m1->params[i]) && memcmp(&m1->params[i].value.numeric,
+          &m2->params[i].value.numeric, sizeof(gdouble)))
+      return FALSE;
+  }
+
+  return TRUE;
+}
+
+static void vm_memo_free ( vm_memo_t *memo )
+{
+  gint i;
+
+  for(i=0; i<memo->np; i++)
+    value_free(memo->params[i]);
+  g_free(memo->params);
+  value_free(memo->result);
+  g_free(memo);
+}
+
+static gboolean vm_memo_key ( vm_memo_t *key, vm_t *vm, vm_function_t *func,
+    guint8 np )
+{
+  gint i;
+
+  if(!(func->flags & VM_FUNC_MEMOIZE) || (func->flags & VM_FUNC_USERDEFINED))
+    return FALSE;
+
+  key->ip = vm->ip;
+  key->func = func;
+  key->np = np;
+  key->params = (value_t *)vm->stack->data + vm->stack->len - np;
+  key->hash = g_direct_hash(vm->ip);
+
+  for(i=0; i<np; i++)
+    if(value_is_array(key->params[i]))
+      return FALSE;
+    else if(value_is_string(key->params[i]))
+      key->hash = key->hash*31 + (key->params[i].value.string?
+          g_str_hash(key->params[i].value.string) : 0);
+    else if(value_is_numeric(key->params[i]))
+      key->hash = key->hash*31 + g_double_hash(&key->params[i].value.numeric);
+    else
+      key->hash = key->hash*31 + key->params[i].type;
+
+  return TRUE;
+}
+
+static gboolean vm_memo_lookup ( vm_memo_t *key, value_t *result )
+{
+  vm_memo_t *memo;
+
+  g_mutex_lock(&vm_memo_mutex);
+  if( (memo = vm_memo? g_hash_table_lookup(vm_memo, key) : NULL) )
+    *result = value_dup(memo->result);
+  g_mutex_unlock(&vm_memo_mutex);
+
+  return !!memo;
+}
+
+static void vm_memo_insert ( vm_memo_t *key, value_t result )
+{
+  vm_memo_t *memo;
+  gint i;
+
+  memo = g_memdup2(key, sizeof(vm_memo_t));
+  memo->params = g_malloc(sizeof(value_t)*MAX(1, key->np));
+  for(i=0; i<key->np; i++)
+    memo->params[i] = value_dup(key->params[i]);
+  memo->result = value_dup(result);
+
+  g_mutex_lock(&vm_memo_mutex);
+  if(!vm_memo)
+    vm_memo = g_hash_table_new_full((GHashFunc)vm_memo_hash,
+        (GEqualFunc)vm_memo_equal, (GDestroyNotify)vm_memo_free, NULL);
+  if(g_hash_table_size(vm_memo) >= VM_MEMO_MAX)
+    g_hash_table_remove_all(vm_memo);
+  g_hash_table_add(vm_memo, memo);
+  g_mutex_unlock(&vm_memo_mutex);
+}
+
 static gboolean vm_function ( vm_t *vm )
 {
+  vm_memo_t key;
+  gboolean memoize;
   vm_function_t *func;
   value_t result;
   guint8 np = *(vm->ip+1);
@@ -155,19 +269,24 @@ static gboolean vm_function ( vm_t *vm )
   }
 
   result = value_na;
-  if(!(func->flags & VM_FUNC_USERDEFINED) && func->ptr.function)
+  memoize = func->ptr.function && vm_memo_key(&key, vm, func, np);
+  if(memoize && vm_memo_lookup(&key, &result))
+    memoize = FALSE;
+  else if(!(func->flags & VM_FUNC_USERDEFINED) && func->ptr.function)
   {
     result = func->ptr.function(vm,
         (value_t *)vm->stack->data + vm->stack->len - np, np);
     if(vm->expr)
       vm->expr->vstate |= !(func->flags & VM_FUNC_DETERMINISTIC);
+    if(memoize)
+      vm_memo_insert(&key, result);
   }
   else if(func->flags & VM_FUNC_USERDEFINED)
     result = vm_function_call(vm, func->ptr.code, np);
   else
     result = value_na;
 
-  expr_dep_add(g_quark_from_string(func->name), vm->expr);
+  expr_dep_add(func->quark, vm->expr);
   if(np>1 && vm->pstack->len>np-1)
     g_ptr_array_remove_range(vm->pstack, vm->pstack->len-np+1, np-1);
   else if(!np)
@@ -218,8 +337,6 @@ static void vm_local ( vm_t *vm )
   vm_push(vm, value_dup(((value_t *)(vm->stack->data))[vm->fp+pos-1]));
   g_ptr_array_add(vm->pstack, vm->ip);
   vm->ip += sizeof(guint16);
-  if(vm->expr)
-    vm->expr->vstate = TRUE;
 }
 
 static void vm_local_assign ( vm_t *vm )
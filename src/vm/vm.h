@@ -25,6 +25,7 @@ enum expr_instruction_t {
 enum vm_func_flags_t {
   VM_FUNC_DETERMINISTIC = 1,
   VM_FUNC_USERDEFINED = 2,
+  VM_FUNC_MEMOIZE = 4,
 };
 
 typedef struct _vm_store_t vm_store_t;
@@ -63,6 +64,7 @@ typedef value_t (*vm_func_t)(vm_t *vm, value_t params[], gint np);
 
 typedef struct {
   gchar *name;
+  GQuark quark;
   guint8 flags;
   union {
     vm_func_t function;
@@ -99,8 +101,12 @@ void vm_run_action ( GBytes *code, GtkWidget *w, GdkEvent *e, window_t *win,
 void vm_run_user_defined ( gchar *action, GtkWidget *widget, GdkEvent *event,
     window_t *win, guint16 *state, vm_store_t *store );
 
+gboolean vm_code_verify ( GBytes *code, gint *max, gint *end, gchar **err );
+gchar *vm_code_disasm ( GBytes *code );
+GQuark *vm_code_reads ( GBytes *code );
+
 void vm_func_init ( void );
-void vm_func_add ( gchar *name, vm_func_t func, gboolean deterministic );
+void vm_func_add ( gchar *name, vm_func_t func, guint8 flags );
 void vm_func_add_user ( gchar *name, GBytes *code );
 vm_function_t *vm_func_lookup ( gchar *name );
 void vm_func_remove ( gchar *name );
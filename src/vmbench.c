@@ -0,0 +1,191 @@
+/* This entire file is licensed under GNU General Public License v3.0
+ *
+ * Copyright 2025- sfwbar maintainers
+ */
+
+/* sfwbar-vm-bench: compile expressions from a file (one per line), verify
+ * and optionally disassemble the bytecode, then time repeated evaluations
+ * without creating any windows */
+
+#include <stdio.h>
+#include "sfwbar.h"
+#include "bench.h"
+#include "scanner.h"
+#include "config/config.h"
+#include "util/profile.h"
+#include "vm/vm.h"
+
+static gint iterations = 100000;
+static gboolean disasm;
+static gboolean verify_only;
+static gint ticks;
+
+static GOptionEntry entries[] = {
+  { "iterations", 'n', 0, G_OPTION_ARG_INT, &iterations,
+    "Evaluations per expression (default 100000)", "N" },
+  { "disassemble", 'd', 0, G_OPTION_ARG_NONE, &disasm,
+    "Print bytecode for each expression", NULL },
+  { "verify", 'v', 0, G_OPTION_ARG_NONE, &verify_only,
+    "Only verify the bytecode, don't run it", NULL },
+  { "ticks", 't', 0, G_OPTION_ARG_INT, &ticks,
+    "Check the expression stays scheduled for N one second ticks", "N" },
+  { NULL }
+};
+
+static gchar *vm_bench_value_print ( value_t v1 )
+{
+  if(value_is_string(v1))
+    return g_strdup_printf("\"%s\"", value_get_string(v1));
+  if(value_is_numeric(v1))
+    return g_strdup_printf("%g", value_get_numeric(v1));
+  if(value_is_array(v1))
+    return g_strdup_printf("array[%u]", value_get_array(v1)->len);
+  return g_strdup("n/a");
+}
+
+/* run the expression through an expr_cache_t the way a widget polling
+ * once a second would, and check that it stays scheduled and picks up
+ * changes in the scanner variables it reads */
+static gboolean vm_bench_ticks ( GBytes *code )
+{
+  expr_cache_t *expr;
+  gint i, changes = 0;
+  gboolean result = TRUE;
+
+  expr = expr_cache_new_with_code(g_bytes_ref(code));
+  (void)expr_cache_eval(expr);
+  for(i=1; i<=ticks; i++)
+  {
+    g_usleep(G_USEC_PER_SEC);
+    scanner_invalidate();
+    if(!expr_cache_needs_poll(expr))
+    {
+      printf("  tick %d: no longer scheduled\n", i);
+      result = FALSE;
+      break;
+    }
+    if(expr_cache_eval(expr))
+      changes++;
+  }
+  printf("  %d of %d ticks changed the value (%s)\n", changes, ticks,
+      expr->cache? expr->cache : "");
+  expr_cache_free(expr);
+
+  return result;
+}
+
+static gboolean vm_bench_expr ( gchar *expr, gint line )
+{
+  GBytes *code;
+  GQuark *reads;
+  value_t v1;
+  gchar *err, *text;
+  gint64 start, elapsed;
+  gint max, end, count, i;
+
+  printf("%d: %s\n", line, expr);
+  if( !(code = parser_expr_compile(expr)) )
+  {
+    printf("  parse error\n");
+    return FALSE;
+  }
+
+  if(disasm)
+  {
+    text = vm_code_disasm(code);
+    printf("%s", text);
+    g_free(text);
+    reads = vm_code_reads(code);
+    printf("  reads:");
+    for(i=0; reads[i]; i++)
+      printf(" %s", g_quark_to_string(reads[i]));
+    printf("\n");
+    g_free(reads);
+  }
+
+  if(!vm_code_verify(code, &max, &end, &err))
+  {
+    printf("  verify failed: %s\n", err);
+    g_free(err);
+    g_bytes_unref(code);
+    return FALSE;
+  }
+  printf("  %zu bytes, max stack %d", g_bytes_get_size(code), max);
+  if(end!=1)
+    printf(", leaves %d values", end);
+  printf("\n");
+
+  if(!verify_only && iterations>0)
+  {
+    v1 = vm_code_eval(code, NULL);
+    text = vm_bench_value_print(v1);
+    value_free(v1);
+
+    count = bench_allocs();
+    start = profile_now();
+    for(i=0; i<iterations; i++)
+      value_free(vm_code_eval(code, NULL));
+    elapsed = profile_now() - start;
+    count = bench_allocs() - count;
+
+    printf("  %.1f ns/eval", (gdouble)elapsed/iterations);
+    if(bench_allocs_supported())
+      printf(", %.2f allocs/eval", (gdouble)count/iterations);
+    printf(", result: %s\n", text);
+    g_free(text);
+  }
+
+  if(ticks>0 && !vm_bench_ticks(code))
+  {
+    g_bytes_unref(code);
+    return FALSE;
+  }
+
+  g_bytes_unref(code);
+  return TRUE;
+}
+
+int main ( int argc, gchar **argv )
+{
+  GOptionContext *optc;
+  GError *error = NULL;
+  gchar *data, **lines, *expr;
+  gint i, failed = 0;
+
+  optc = g_option_context_new("FILE - benchmark sfwbar expressions");
+  g_option_context_add_main_entries(optc, entries, NULL);
+  if(!g_option_context_parse(optc, &argc, &argv, &error) || argc!=2)
+  {
+    fprintf(stderr, "%s", error? error->message : "");
+    fprintf(stderr, "\n%s", g_option_context_get_help(optc, TRUE, NULL));
+    return 1;
+  }
+  g_option_context_free(optc);
+
+  if(!g_file_get_contents(argv[1], &data, NULL, &error))
+  {
+    fprintf(stderr, "%s\n", error->message);
+    return 1;
+  }
+
+  config_init();
+  expr_lib_init();
+  action_lib_init();
+  if(ticks>0)
+  {
+    scanner_file_native_new(SO_PROCSTAT, NULL);
+    scanner_file_native_new(SO_MEMINFO, NULL);
+  }
+
+  lines = g_strsplit(data, "\n", -1);
+  for(i=0; lines[i]; i++)
+  {
+    expr = g_strstrip(lines[i]);
+    if(*expr && *expr!='#' && !vm_bench_expr(expr, i+1))
+      failed++;
+  }
+  g_strfreev(lines);
+  g_free(data);
+
+  return !!failed;
+}
@@ -5,6 +5,7 @@
 
 #include "wintree.h"
 #include "trigger.h"
+#include "util/profile.h"
 #include "util/string.h"
 
 static struct wintree_api *api;
@@ -24,8 +25,9 @@ struct appid_mapper {
 #define LISTENER_CALL(method, win) { \
   for(GList *li=wintree_listeners; li; li=li->next) \
     if(WINTREE_LISTENER(li->data)->method) \
-      WINTREE_LISTENER(li->data)->method(win, \
-          WINTREE_LISTENER(li->data)->data); \
+      PROFILE_CALL(#method, WINTREE_LISTENER(li->data)->data, \
+          WINTREE_LISTENER(li->data)->method(win, \
+            WINTREE_LISTENER(li->data)->data)); \
 }
 
 #define api_call(x) if(api->x) api->x(id);
@@ -126,26 +128,38 @@ gint wintree_compare ( window_t *a, window_t *b)
   return GPOINTER_TO_INT(a->uid - b->uid);
 }
 
-void wintree_set_focus ( gpointer id )
+/* move the focus and raise the window to the front of the list without
+ * notifying listeners, returns the id of the previously focused window */
+gpointer wintree_focus_swap ( gpointer id )
 {
   GList *iter;
+  gpointer prev;
 
-  if(wt_focus == id)
-    return;
-  wintree_commit(wintree_from_id(wt_focus));
+  prev = wt_focus;
   wt_focus = id;
   for(iter=wt_list; iter; iter=g_list_next(iter) )
     if (((window_t *)(iter->data))->uid == id)
       break;
-  if(!iter)
-    return;
-  if(g_list_previous(iter))
+  if(iter && g_list_previous(iter))
   {
     g_list_previous(iter)->next = NULL;
     iter->prev = NULL;
     wt_list = g_list_concat(iter, wt_list);
   }
-  wintree_commit(wt_list->data);
+
+  return prev;
+}
+
+void wintree_set_focus ( gpointer id )
+{
+  window_t *win;
+
+  if(wt_focus == id)
+    return;
+  wintree_commit(wintree_from_id(wintree_focus_swap(id)));
+  if( !(win = wintree_from_id(id)) )
+    return;
+  wintree_commit(win);
   trigger_emit("window_focus");
 }
 
@@ -213,32 +227,29 @@ void wintree_set_app_id ( gpointer wid, const gchar *app_id)
 
   if(!app_id || !( win=wintree_from_id(wid)) || !g_strcmp0(win->appid, app_id))
     return;
-  LISTENER_CALL(window_destroy, win);
   g_free(win->appid);
   win->appid = g_strdup(app_id);
   if(!win->title)
     win->title = g_strdup(app_id);
-  LISTENER_CALL(window_new, win);
-
-  wintree_commit(win);
+  LISTENER_CALL(window_regroup, win);
 }
 
 void wintree_set_workspace ( gpointer wid, gpointer wsid )
 {
   window_t *win;
-  workspace_t *ws;
+  workspace_t *ws, *old;
 
   win = wintree_from_id(wid);
   ws = workspace_from_id(wsid);
   if(!win || !ws || win->workspace == ws)
     return;
 
-  LISTENER_CALL(window_destroy, win);
-  if(win->workspace)
-    workspace_unref(win->workspace->id);
+  old = win->workspace;
   win->workspace = ws;
   workspace_ref(wsid);
-  LISTENER_CALL(window_new, win);
+  LISTENER_CALL(window_regroup, win);
+  if(old)
+    workspace_unref(old->id);
 }
 
 void wintree_set_float ( gpointer wid, gboolean floating )
@@ -251,7 +262,9 @@ void wintree_set_float ( gpointer wid, gboolean floating )
   wintree_commit(win);
 }
 
-void wintree_window_append ( window_t *win )
+/* add a window, announcing it with window_new only. A focused window goes
+ * to the front of the list */
+void wintree_window_add ( window_t *win )
 {
   if(!win)
     return;
@@ -259,7 +272,16 @@ void wintree_window_append ( window_t *win )
   if(win->title || win->appid)
     LISTENER_CALL(window_new, win);
   if(!g_list_find(wt_list, win))
-    wt_list = g_list_append (wt_list, win);
+    wt_list = wintree_is_focused(win->uid)? g_list_prepend(wt_list, win) :
+      g_list_append(wt_list, win);
+}
+
+void wintree_window_append ( window_t *win )
+{
+  if(!win)
+    return;
+
+  wintree_window_add(win);
   wintree_commit(win);
 }
 
@@ -304,7 +326,7 @@ void wintree_appid_map_add ( gchar *pattern, gchar *appid )
           g_regex_get_pattern(((struct appid_mapper *)iter->data)->regex)))
       return;
 
-  if( (regex = g_regex_new(pattern, 0, 0, NULL)) )
+  if( (regex = regex_cache_get(pattern)) )
   {
     map = g_malloc0(sizeof(struct appid_mapper));
     map->regex = regex;
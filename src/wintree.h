@@ -32,6 +32,7 @@ typedef struct _window_listener {
   void (*window_new) ( window_t *, void *);
   void (*window_invalidate) ( window_t *, void *);
   void (*window_destroy) ( window_t *, void *);
+  void (*window_regroup) ( window_t *, void *);
   void *data;
 } window_listener_t;
 
@@ -44,10 +45,12 @@ void wintree_listener_remove ( void *data );
 window_t *wintree_window_init ( void );
 window_t *wintree_from_id ( gpointer id );
 window_t *wintree_from_pid ( gint64 pid );
+void wintree_window_add ( window_t *win );
 void wintree_window_append ( window_t *win );
 void wintree_window_delete ( gpointer id );
 void wintree_commit ( window_t *win );
 void wintree_log ( gpointer id );
+gpointer wintree_focus_swap ( gpointer id );
 void wintree_set_focus ( gpointer id );
 void wintree_set_active ( gchar *title );
 void wintree_set_title ( gpointer wid, const gchar *title );
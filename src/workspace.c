@@ -5,6 +5,7 @@
 
 #include "workspace.h"
 #include "gui/monitor.h"
+#include "util/profile.h"
 #include "util/string.h"
 
 static struct workspace_api *api;
@@ -13,12 +14,51 @@ static GList *global_pins;
 static GList *workspaces;
 static GList *workspace_listeners;
 static GHashTable *actives;
+static GHashTable *ws_by_id, *ws_by_name;
 
 #define LISTENER_CALL(method, ws) { \
   for(GList *li=workspace_listeners; li; li=li->next) \
     if(WORKSPACE_LISTENER(li->data)->method) \
-      WORKSPACE_LISTENER(li->data)->method(ws, \
-          WORKSPACE_LISTENER(li->data)->data); \
+      PROFILE_CALL(#method, WORKSPACE_LISTENER(li->data)->data, \
+          WORKSPACE_LISTENER(li->data)->method(ws, \
+            WORKSPACE_LISTENER(li->data)->data)); \
+}
+
+/* pins share PAGER_PIN_ID and are only indexed by name. If several
+ * workspaces share a name, the index holds one of them */
+static void workspace_index_add ( workspace_t *ws )
+{
+  if(!ws_by_id)
+  {
+    ws_by_id = g_hash_table_new(g_direct_hash, g_direct_equal);
+    ws_by_name = g_hash_table_new(g_str_hash, g_str_equal);
+  }
+
+  if(ws->id && ws->id != PAGER_PIN_ID)
+    g_hash_table_insert(ws_by_id, ws->id, ws);
+  if(ws->name && !g_hash_table_lookup(ws_by_name, ws->name))
+    g_hash_table_insert(ws_by_name, ws->name, ws);
+}
+
+static void workspace_index_remove ( workspace_t *ws )
+{
+  GList *iter;
+
+  if(!ws_by_id)
+    return;
+
+  if(g_hash_table_lookup(ws_by_id, ws->id) == ws)
+    g_hash_table_remove(ws_by_id, ws->id);
+
+  if(!ws->name || g_hash_table_lookup(ws_by_name, ws->name) != ws)
+    return;
+  g_hash_table_remove(ws_by_name, ws->name);
+  for(iter=workspaces; iter; iter=g_list_next(iter))
+    if(iter->data!=ws && !g_strcmp0(WORKSPACE(iter->data)->name, ws->name))
+    {
+      g_hash_table_insert(ws_by_name, WORKSPACE(iter->data)->name, iter->data);
+      break;
+    }
 }
 
 void workspace_api_register ( struct workspace_api *new )
@@ -89,12 +129,13 @@ void workspace_unref ( gpointer id )
   if(g_list_find_custom(global_pins, ws->name, (GCompareFunc)g_strcmp0))
   {
     g_debug("Workspace: workspace returned to a pin: '%s'", ws->name);
-    ws->id = PAGER_PIN_ID;
+    workspace_set_id(ws, PAGER_PIN_ID);
     ws->state = 0;
     LISTENER_CALL(workspace_destroy, ws);
   }
   else
   {
+    workspace_index_remove(ws);
     workspaces = g_list_remove(workspaces, ws);
     LISTENER_CALL(workspace_destroy, ws);
     g_free(ws->name);
@@ -104,23 +145,28 @@ void workspace_unref ( gpointer id )
 
 workspace_t *workspace_from_id ( gpointer id )
 {
-  GList *iter;
-
-  for(iter=workspaces; iter; iter=g_list_next(iter))
-    if(WORKSPACE(iter->data)->id == id)
-      return iter->data;
+  if(!ws_by_id || id == PAGER_PIN_ID)
+    return NULL;
 
-  return NULL;
+  return g_hash_table_lookup(ws_by_id, id);
 }
 
 workspace_t *workspace_from_name ( const gchar *name )
 {
-  GList *iter;
+  if(!ws_by_name || !name)
+    return NULL;
 
-  for(iter=workspaces; iter; iter=g_list_next(iter))
-    if(!g_strcmp0(WORKSPACE(iter->data)->name, name))
-      return iter->data;
-  return NULL;
+  return g_hash_table_lookup(ws_by_name, name);
+}
+
+void workspace_set_id ( workspace_t *ws, gpointer id )
+{
+  if(!ws || ws->id == id)
+    return;
+
+  workspace_index_remove(ws);
+  ws->id = id;
+  workspace_index_add(ws);
 }
 
 gpointer workspace_id_from_name ( const gchar *name )
@@ -160,17 +206,11 @@ gboolean workspace_get_can_create ( void )
 static void workspace_pin_remove ( const gchar *pin )
 {
   workspace_t *ws;
-  GList *iter;
 
-  for(iter=workspaces; iter; iter=g_list_next(iter))
-    if(!g_strcmp0(WORKSPACE(iter->data)->name, pin) &&
-        WORKSPACE(iter->data)->id == PAGER_PIN_ID)
-      break;
-
-  if(!iter)
+  if( !(ws = workspace_from_name(pin)) || ws->id != PAGER_PIN_ID)
     return;
 
-  ws = iter->data;
+  workspace_index_remove(ws);
   g_free(ws->name);
   ws->name = "";
   LISTENER_CALL(workspace_destroy, ws);
@@ -192,6 +232,7 @@ static void workspace_pin_restore ( const gchar *pin )
   ws->id = PAGER_PIN_ID;
   ws->name = g_strdup(pin);
   workspaces = g_list_prepend(workspaces, ws);
+  workspace_index_add(ws);
   LISTENER_CALL(workspace_new, ws);
 }
 
@@ -220,11 +261,6 @@ gpointer workspace_get_active ( GtkWidget *widget )
 
 void workspace_set_active ( workspace_t *ws, const gchar *output )
 {
-  GdkDisplay *gdisp;
-  GdkMonitor *gmon;
-  gchar *name;
-  gint i;
-
   if(!output || !ws)
     return;
 
@@ -232,14 +268,7 @@ void workspace_set_active ( workspace_t *ws, const gchar *output )
     actives = g_hash_table_new_full((GHashFunc)str_nhash,
         (GEqualFunc)str_nequal, g_free, NULL);
 
-  gdisp = gdk_display_get_default();
-  for(i=gdk_display_get_n_monitors(gdisp)-1; i>=0; i--)
-  {
-    gmon = gdk_display_get_monitor(gdisp, i);
-    name = monitor_get_name(gmon);
-    if(name && !g_strcmp0(name, output))
-      g_hash_table_insert(actives, g_strdup(name), ws->id);
-  }
+  g_hash_table_replace(actives, g_strdup(output), ws->id);
 }
 
 gpointer workspace_get_focused ( void )
@@ -303,8 +332,10 @@ void workspace_set_name ( workspace_t *ws, const gchar *name )
 
   g_debug("Workspace: '%s' (pin: %s)  name change to: '%s' (duplicate: %s)",
       ws->name, old_pin?"yes":"no", name, old?"yes":"no");
+  workspace_index_remove(ws);
   g_free(ws->name);
   ws->name = g_strdup(name);
+  workspace_index_add(ws);
   ws->state |= WS_STATE_INVALID;
 
   if(old_pin && !workspace_from_name(old_pin->data))
@@ -329,6 +360,7 @@ workspace_t *workspace_new ( gpointer id )
     ws->id = id;
     ws->refcount = 0;
     workspaces = g_list_append(workspaces, ws);
+    workspace_index_add(ws);
     workspace_ref(id);
     LISTENER_CALL(workspace_new, ws);
   }
@@ -56,6 +56,7 @@ void workspace_set_active ( workspace_t *ws, const gchar *output );
 gpointer workspace_get_active ( GtkWidget *widget );
 gpointer workspace_id_from_name ( const gchar *name );
 workspace_t *workspace_from_id ( gpointer id );
+void workspace_set_id ( workspace_t *ws, gpointer id );
 gpointer workspace_get_focused ( void );
 void workspace_activate ( workspace_t *ws );
 guint workspace_get_geometry ( gpointer wid, GdkRectangle *wloc, gpointer wsid,